@@ -0,0 +1,149 @@
+#ifndef DRAUPNIR_BIT_GENERATOR_H__
+#define DRAUPNIR_BIT_GENERATOR_H__
+
+#include <array>
+#include <cstdint>
+#include <limits>
+
+#include "Sponge.h"
+
+namespace Draupnir {
+
+  namespace Random {
+
+    /**
+     * UniformRandomBitGenerator adapter over a sponge
+     *
+     * This class allows for a sponge to be used wherever the standard library
+     * (or any third-party library) expects a UniformRandomBitGenerator (eg.
+     * std::shuffle or std::uniform_int_distribution), yielding full 64-bit
+     * words.
+     *
+     * Words are served from an internal block, refilled by a single bulk
+     * squeeze whenever exhausted, so that generating a word amounts to a load
+     * and an index bump. Each word is composed in big-endian order from the
+     * bytes squeezed, so that the words yielded are exactly those
+     * Draupnir::Random would extract from the same sponge.
+     *
+     * Note that bytes are squeezed a block at a time: after using the adapter,
+     * the sponge is left positioned past the words still buffered.
+     *
+     * The template parameter establishes the sponge type to squeeze from (a
+     * concrete type allows for the bulk squeeze to be devirtualized).
+     *
+     */
+    template <typename S = Draupnir::Sponge>
+    class BitGenerator {
+      public:
+        /**
+         * Type of the values generated
+         *
+         */
+        using result_type = std::uint64_t;
+
+        /**
+         * Number of words to buffer
+         *
+         */
+        static constexpr std::size_t blockSize = 32;
+
+        /**
+         * Retrieve the smallest value ever generated
+         *
+         * @return the smallest value ever generated
+         */
+        static constexpr result_type min() noexcept { return std::numeric_limits<result_type>::min(); }
+
+        /**
+         * Retrieve the largest value ever generated
+         *
+         * @return the largest value ever generated
+         */
+        static constexpr result_type max() noexcept { return std::numeric_limits<result_type>::max(); }
+
+        /**
+         * Main constructor
+         *
+         * The given sponge must outlive the adapter.
+         *
+         * @param s  Sponge to use for randomization
+         */
+        explicit BitGenerator(S &s) noexcept;
+
+        /**
+         * Copy constructor - defaulted
+         *
+         * Note that the copy will yield the very same words buffered in the
+         * original.
+         *
+         * @param other  BitGenerator to copy from
+         */
+        BitGenerator(BitGenerator const &other) noexcept = default;
+
+        /**
+         * Move constructor - defaulted
+         *
+         * @param other  BitGenerator to move from
+         */
+        BitGenerator(BitGenerator &&other) noexcept = default;
+
+        /**
+         * Destructor - defaulted
+         *
+         */
+        ~BitGenerator() noexcept = default;
+
+        /**
+         * Generate a random word
+         *
+         * @return the word generated
+         */
+        result_type operator()() noexcept;
+
+        /**
+         * Discard the given number of words
+         *
+         * @param n  Number of words to discard
+         */
+        void discard(unsigned long long n) noexcept;
+
+        /**
+         * Retrieve the underlying sponge
+         *
+         * @return the sponge being squeezed
+         */
+        S &sponge() const noexcept;
+
+      protected:
+        /**
+         * Refill the word block by means of a single bulk squeeze
+         *
+         */
+        void refill() noexcept;
+
+        /**
+         * Sponge to use for randomization
+         *
+         */
+        S &_sponge;
+
+        /**
+         * Index of the next word to yield (blockSize if exhausted)
+         *
+         */
+        std::size_t _next;
+
+        /**
+         * Word block
+         *
+         */
+        std::array<result_type, blockSize> _block;
+    };
+
+  }
+
+}
+
+#include "BitGenerator.hpp"
+
+#endif /* DRAUPNIR_BIT_GENERATOR_H__ */
@@ -0,0 +1,93 @@
+#ifndef DRAUPNIR_BIT_GENERATOR_HPP__
+#define DRAUPNIR_BIT_GENERATOR_HPP__
+
+#include "BitGenerator.h"
+
+namespace Draupnir {
+
+  namespace Random {
+
+    template <typename S>
+    constexpr std::size_t BitGenerator<S>::blockSize;
+
+    /**
+     * BitGenerator main constructor
+     *
+     * The given sponge must outlive the adapter; nothing is squeezed until
+     * the first word is requested.
+     *
+     * @param s  Sponge to use for randomization
+     */
+    template <typename S>
+    BitGenerator<S>::BitGenerator(S &s) noexcept
+      :
+    _sponge {s},
+    _next {blockSize},
+    _block {}
+    {}
+
+    /**
+     * Generate a random word
+     *
+     * @return the word generated
+     */
+    template <typename S>
+    typename BitGenerator<S>::result_type BitGenerator<S>::operator()() noexcept {
+      if (blockSize <= _next) {
+        refill();
+      }
+      return _block[_next++];
+    }
+
+    /**
+     * Discard the given number of words
+     *
+     * Whole blocks are still squeezed (and thrown away), so that the words
+     * yielded afterwards are the same as if the discarded ones had been
+     * generated.
+     *
+     * @param n  Number of words to discard
+     */
+    template <typename S>
+    void BitGenerator<S>::discard(unsigned long long n) noexcept {
+      while (blockSize - _next < n) {
+        n -= blockSize - _next;
+        refill();
+      }
+      _next += static_cast<std::size_t>(n);
+    }
+
+    /**
+     * Retrieve the underlying sponge
+     *
+     * @return the sponge being squeezed
+     */
+    template <typename S>
+    S &BitGenerator<S>::sponge() const noexcept {
+      return _sponge;
+    }
+
+    /**
+     * Refill the word block by means of a single bulk squeeze
+     *
+     */
+    template <typename S>
+    void BitGenerator<S>::refill() noexcept {
+      std::array<std::uint8_t, blockSize * sizeof(result_type)> bytes;
+      _sponge.squeeze(bytes.data(), bytes.size());
+
+      for (std::size_t i = 0, k = 0; i < blockSize; i++) {
+        result_type word = 0;
+        for (std::size_t j = 0; j < sizeof(result_type); j++, k++) {
+          word = (word << 8) | bytes[k];
+        }
+        _block[i] = word;
+      }
+      _next = 0;
+    }
+
+  }
+
+}
+
+#endif /* DRAUPNIR_BIT_GENERATOR_HPP__ */
@@ -0,0 +1,444 @@
+#include "BulkWriter.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+/**
+ * Number of blocks in the ring
+ *
+ */
+constexpr std::size_t bulkWriterSlots = 8;
+
+/**
+ * Number of values held by each Natural or Real block
+ *
+ */
+constexpr std::size_t bulkWriterBlockValues = std::size_t(1) << 12;
+
+/**
+ * Number of bytes held by each Bytes or Hex block
+ *
+ */
+constexpr std::size_t bulkWriterBlockBytes = std::size_t(1) << 16;
+
+/**
+ * Size of the formatter thread's output buffer
+ *
+ */
+constexpr std::size_t bulkWriterBufferSize = std::size_t(1) << 20;
+
+/**
+ * Number of decimals to write real numbers with
+ *
+ */
+constexpr int bulkWriterRealDecimals = std::numeric_limits<long double>::digits10 + 1;
+
+/**
+ * Two-digit decimal lookup table
+ *
+ */
+constexpr char decimalPairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+/**
+ * Hexadecimal digits
+ *
+ */
+constexpr char hexDigits[] = "0123456789abcdef";
+
+}
+
+namespace Draupnir {
+
+/**
+ * Construct a new BulkWriter on the given ostream, starting its formatter thread
+ *
+ * Every block's storage is allocated up front, so that writing values never
+ * allocates.
+ *
+ * @param out  Ostream to write to
+ * @throws std::system_error in case the formatter thread cannot be started
+ */
+BulkWriter::BulkWriter(std::ostream &out) :
+    _out{out},
+    _ring(bulkWriterSlots, Block{
+        std::vector<std::uint64_t>(bulkWriterBlockValues),
+        std::vector<long double>(bulkWriterBlockValues),
+        std::vector<char>(bulkWriterBlockValues),
+        std::vector<std::uint8_t>(bulkWriterBlockBytes),
+        0, Kind::Bytes, false
+    }),
+    _buffer(bulkWriterBufferSize),
+    _used{0},
+    _published{0},
+    _formatted{0},
+    _mutex{},
+    _filled{},
+    _freed{},
+    _thread{} {
+  _thread = std::thread(&BulkWriter::run, this);
+}
+
+/**
+ * Destructor - write out everything pending and stop the formatter thread
+ *
+ * The formatter thread is stopped by handing it a Stop block.
+ *
+ */
+BulkWriter::~BulkWriter() noexcept {
+  sync();
+  current(Kind::Stop);
+  publish(false);
+  _thread.join();
+}
+
+/**
+ * Write a natural number (in decimal), followed by the given terminator
+ *
+ * @param value  Value to write
+ * @param terminator  Character to write after the value
+ * @return the BulkWriter itself
+ */
+BulkWriter &BulkWriter::natural(std::uint64_t value, char terminator) noexcept {
+  Block &block = current(Kind::Natural);
+  block.naturals[block.size] = value;
+  block.terminators[block.size] = terminator;
+  block.size++;
+  return *this;
+}
+
+/**
+ * Write a real number (in fixed notation, with as many decimals as a long double's precision warrants), followed by the given terminator
+ *
+ * @param value  Value to write
+ * @param terminator  Character to write after the value
+ * @return the BulkWriter itself
+ */
+BulkWriter &BulkWriter::real(long double value, char terminator) noexcept {
+  Block &block = current(Kind::Real);
+  block.reals[block.size] = value;
+  block.terminators[block.size] = terminator;
+  block.size++;
+  return *this;
+}
+
+/**
+ * Write the given bytes verbatim
+ *
+ * @param data  Pointer to the bytes to write
+ * @param size  Number of bytes to write
+ * @return the BulkWriter itself
+ */
+BulkWriter &BulkWriter::bytes(std::uint8_t const *data, std::size_t size) noexcept {
+  while (0 < size) {
+    Block &block = current(Kind::Bytes);
+    std::size_t n = std::min(size, bulkWriterBlockBytes - block.size);
+    std::memcpy(block.data.data() + block.size, data, n);
+    block.size += n;
+    data += n;
+    size -= n;
+  }
+  return *this;
+}
+
+/**
+ * Write the given bytes as pairs of hexadecimal digits
+ *
+ * @param data  Pointer to the bytes to write
+ * @param size  Number of bytes to write
+ * @return the BulkWriter itself
+ */
+BulkWriter &BulkWriter::hex(std::uint8_t const *data, std::size_t size) noexcept {
+  while (0 < size) {
+    Block &block = current(Kind::Hex);
+    std::size_t n = std::min(size, bulkWriterBlockBytes - block.size);
+    std::memcpy(block.data.data() + block.size, data, n);
+    block.size += n;
+    data += n;
+    size -= n;
+  }
+  return *this;
+}
+
+/**
+ * Retrieve a region to write bytes into in place, of at least the given size
+ *
+ * The region lies within the current block's storage, so that whatever is
+ * written there need not be copied before being handed over.
+ *
+ * @param minimum  Minimum size of the region (at most 65536 bytes)
+ * @param available  Output size of the region
+ * @return a pointer to the region's first byte
+ */
+std::uint8_t *BulkWriter::acquire(std::size_t minimum, std::size_t &available) noexcept {
+  Block *block = &current(Kind::Bytes);
+  if (bulkWriterBlockBytes - block->size < minimum) {
+    publish(false);
+    block = &current(Kind::Bytes);
+  }
+  available = bulkWriterBlockBytes - block->size;
+  return block->data.data() + block->size;
+}
+
+/**
+ * Commit the given number of bytes written in place into the region last acquired
+ *
+ * @param size  Number of bytes to commit
+ * @return the BulkWriter itself
+ */
+BulkWriter &BulkWriter::commit(std::size_t size) noexcept {
+  _ring[_published.load(std::memory_order_relaxed) % bulkWriterSlots].size += size;
+  return *this;
+}
+
+/**
+ * Write the given text verbatim
+ *
+ * @param text  Text to write
+ * @return the BulkWriter itself
+ */
+BulkWriter &BulkWriter::text(std::string const &text) noexcept {
+  return bytes(reinterpret_cast<std::uint8_t const *>(text.data()), text.size());
+}
+
+/**
+ * Hand the current block over to the formatter thread, requesting the ostream to be flushed once it is written
+ *
+ * This does not wait for the block to be written.
+ *
+ * @return the BulkWriter itself
+ */
+BulkWriter &BulkWriter::flush() noexcept {
+  publish(true);
+  return *this;
+}
+
+/**
+ * Flush, and wait for everything pending to be written
+ *
+ * @return the BulkWriter itself
+ */
+BulkWriter &BulkWriter::sync() noexcept {
+  flush();
+  await(0);
+  return *this;
+}
+
+/**
+ * Retrieve the block currently being filled, making it hold values of the given kind
+ *
+ * Should the current block hold values of a different kind, or be full,
+ * it is handed over to the formatter thread first.
+ *
+ * @param kind  Kind of values to hold
+ * @return the block currently being filled
+ */
+BulkWriter::Block &BulkWriter::current(Kind kind) noexcept {
+  Block *block = &_ring[_published.load(std::memory_order_relaxed) % bulkWriterSlots];
+  std::size_t capacity = Kind::Natural == kind || Kind::Real == kind ? bulkWriterBlockValues : bulkWriterBlockBytes;
+  if ((kind != block->kind && 0 != block->size) || capacity == block->size) {
+    publish(false);
+    block = &_ring[_published.load(std::memory_order_relaxed) % bulkWriterSlots];
+  }
+  block->kind = kind;
+  return *block;
+}
+
+/**
+ * Hand the current block over to the formatter thread, waiting for a free one to fill
+ *
+ * @param flush  Whether to flush the ostream after writing the block
+ */
+void BulkWriter::publish(bool flush) noexcept {
+  std::size_t published = _published.load(std::memory_order_relaxed);
+  _ring[published % bulkWriterSlots].flush = flush;
+  _published.store(++published, std::memory_order_release);
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+  }
+  _filled.notify_one();
+
+  await(bulkWriterSlots - 1);
+  Block &next = _ring[published % bulkWriterSlots];
+  next.size = 0;
+  next.flush = false;
+}
+
+/**
+ * Wait until at most the given number of published blocks are pending formatting
+ *
+ * The ring's counters are checked without locking first, so that the mutex
+ * is only taken when actually having to sleep.
+ *
+ * @param pending  Maximum number of blocks to leave pending
+ */
+void BulkWriter::await(std::size_t pending) noexcept {
+  std::size_t published = _published.load(std::memory_order_relaxed);
+  auto done = [this, published, pending]() { return published - _formatted.load(std::memory_order_acquire) <= pending; };
+  if (!done()) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _freed.wait(lock, done);
+  }
+}
+
+/**
+ * Format every published block, until handed a Stop block
+ *
+ * The formatter thread sleeps on a condition variable whenever the ring is
+ * empty, and wakes the producer up after each block formatted; the mutex is
+ * taken between updating a counter and notifying, so that no wake-up is
+ * lost between the other end checking the counter and going to sleep.
+ *
+ * Errors writing to the ostream are left for it to report through its state.
+ *
+ */
+void BulkWriter::run() noexcept {
+  for (std::size_t next = 0; ; ) {
+    if (next == _published.load(std::memory_order_acquire)) {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _filled.wait(lock, [this, next]() { return next != _published.load(std::memory_order_acquire); });
+    }
+
+    Block const &block = _ring[next % bulkWriterSlots];
+    if (Kind::Stop == block.kind) {
+      break;
+    }
+    try {
+      format(block);
+      if (block.flush) {
+        drain();
+        _out.flush();
+      }
+    } catch (...) {
+      _used = 0;
+    }
+
+    _formatted.store(++next, std::memory_order_release);
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+    }
+    _freed.notify_one();
+  }
+}
+
+/**
+ * Format the given block into the output buffer, writing it out as needed
+ *
+ * Naturals are formatted by hand, two digits at a time, while reals are
+ * formatted by snprintf (which, unlike ostream insertion, involves neither
+ * locales nor stream state); large byte blocks are written out directly,
+ * rather than being copied into the output buffer first.
+ *
+ * @param block  Block to format
+ */
+void BulkWriter::format(Block const &block) {
+  switch (block.kind) {
+    case Kind::Natural:
+      for (std::size_t i = 0; i < block.size; i++) {
+        char digits[20];
+        char *p = digits + sizeof(digits);
+        std::uint64_t value = block.naturals[i];
+        while (100 <= value) {
+          std::size_t pair = 2 * (value % 100);
+          value /= 100;
+          *--p = decimalPairs[pair + 1];
+          *--p = decimalPairs[pair];
+        }
+        if (10 <= value) {
+          *--p = decimalPairs[2 * value + 1];
+          *--p = decimalPairs[2 * value];
+        } else {
+          *--p = static_cast<char>('0' + value);
+        }
+        std::size_t length = static_cast<std::size_t>(digits + sizeof(digits) - p);
+        char *out = reserve(length + 1);
+        std::memcpy(out, p, length);
+        out[length] = block.terminators[i];
+        _used += length + 1;
+      }
+      break;
+    case Kind::Real:
+      for (std::size_t i = 0; i < block.size; i++) {
+        std::size_t free = _buffer.size() - _used;
+        int length = std::snprintf(_buffer.data() + _used, free, "%.*Lf", bulkWriterRealDecimals, block.reals[i]);
+        if (length < 0) {
+          continue;
+        }
+        if (free <= static_cast<std::size_t>(length)) {
+          drain();
+          if (_buffer.size() <= static_cast<std::size_t>(length)) {
+            std::vector<char> large(static_cast<std::size_t>(length) + 1);
+            std::snprintf(large.data(), large.size(), "%.*Lf", bulkWriterRealDecimals, block.reals[i]);
+            _out.write(large.data(), static_cast<std::streamsize>(length));
+            length = 0;
+          } else {
+            std::snprintf(_buffer.data(), _buffer.size(), "%.*Lf", bulkWriterRealDecimals, block.reals[i]);
+          }
+        }
+        _used += static_cast<std::size_t>(length);
+        *reserve(1) = block.terminators[i];
+        _used++;
+      }
+      break;
+    case Kind::Bytes:
+      if (bulkWriterBlockBytes / 2 <= block.size) {
+        drain();
+        _out.write(reinterpret_cast<char const *>(block.data.data()), static_cast<std::streamsize>(block.size));
+      } else {
+        std::memcpy(reserve(block.size), block.data.data(), block.size);
+        _used += block.size;
+      }
+      break;
+    case Kind::Hex: {
+      char *out = reserve(2 * block.size);
+      for (std::size_t i = 0; i < block.size; i++) {
+        *out++ = hexDigits[block.data[i] >> 4];
+        *out++ = hexDigits[block.data[i] & 0x0f];
+      }
+      _used += 2 * block.size;
+      break;
+    }
+    case Kind::Stop:
+    default:
+      break;
+  }
+}
+
+/**
+ * Make room for the given number of characters in the output buffer, writing it out if needed
+ *
+ * @param size  Number of characters to make room for (at most the buffer's size)
+ * @return a pointer to the first free character in the output buffer
+ */
+char *BulkWriter::reserve(std::size_t size) {
+  if (_buffer.size() - _used < size) {
+    drain();
+  }
+  return _buffer.data() + _used;
+}
+
+/**
+ * Write the output buffer out
+ *
+ */
+void BulkWriter::drain() {
+  if (0 != _used) {
+    _out.write(_buffer.data(), static_cast<std::streamsize>(_used));
+    _used = 0;
+  }
+}
+
+}
@@ -0,0 +1,316 @@
+#ifndef DRAUPNIR_BULK_WRITER_H__
+#define DRAUPNIR_BULK_WRITER_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Draupnir {
+
+  /**
+   * Asynchronous formatted output to an ostream
+   *
+   * Values written to a BulkWriter are not formatted on the spot, but merely
+   * appended to fixed-size blocks, which are handed over to a dedicated
+   * formatter thread through a single-producer single-consumer ring (the
+   * formatter thread sleeping on a condition variable while the ring is
+   * empty, and the producer while it is full); the formatter thread formats
+   * them into a large reusable buffer (naturals by hand, two digits at a
+   * time), and writes it out whenever it fills up or a block explicitly
+   * requests it to be flushed.
+   *
+   * Generation and formatting thus proceed in parallel, and the underlying
+   * ostream sees large writes instead of per-value insertions.
+   *
+   * A BulkWriter must be fed from a single thread at a time.
+   *
+   */
+  class BulkWriter {
+    public:
+      /**
+       * Construct a new BulkWriter on the given ostream, starting its formatter thread
+       *
+       * @param out  Ostream to write to
+       * @throws std::system_error in case the formatter thread cannot be started
+       */
+      explicit BulkWriter(std::ostream &out);
+
+      /**
+       * Copy constructor - deleted
+       *
+       * @param other  BulkWriter to copy from
+       */
+      BulkWriter(BulkWriter const &other) = delete;
+
+      /**
+       * Assignment operator - deleted
+       *
+       * @param other  BulkWriter to assign
+       * @return the newly assigned BulkWriter
+       */
+      BulkWriter &operator=(BulkWriter const &other) = delete;
+
+      /**
+       * Destructor - write out everything pending and stop the formatter thread
+       *
+       */
+      ~BulkWriter() noexcept;
+
+      /**
+       * Write a natural number (in decimal), followed by the given terminator
+       *
+       * @param value  Value to write
+       * @param terminator  Character to write after the value
+       * @return the BulkWriter itself
+       */
+      BulkWriter &natural(std::uint64_t value, char terminator = '\n') noexcept;
+
+      /**
+       * Write a real number (in fixed notation, with as many decimals as a long double's precision warrants), followed by the given terminator
+       *
+       * @param value  Value to write
+       * @param terminator  Character to write after the value
+       * @return the BulkWriter itself
+       */
+      BulkWriter &real(long double value, char terminator = '\n') noexcept;
+
+      /**
+       * Write the given bytes verbatim
+       *
+       * @param data  Pointer to the bytes to write
+       * @param size  Number of bytes to write
+       * @return the BulkWriter itself
+       */
+      BulkWriter &bytes(std::uint8_t const *data, std::size_t size) noexcept;
+
+      /**
+       * Write the given bytes as pairs of hexadecimal digits
+       *
+       * @param data  Pointer to the bytes to write
+       * @param size  Number of bytes to write
+       * @return the BulkWriter itself
+       */
+      BulkWriter &hex(std::uint8_t const *data, std::size_t size) noexcept;
+
+      /**
+       * Retrieve a region to write bytes into in place, of at least the given size
+       *
+       * The bytes written there are only handed over once committed, and no
+       * other BulkWriter method may be called in between.
+       *
+       * @param minimum  Minimum size of the region (at most 65536 bytes)
+       * @param available  Output size of the region
+       * @return a pointer to the region's first byte
+       */
+      std::uint8_t *acquire(std::size_t minimum, std::size_t &available) noexcept;
+
+      /**
+       * Commit the given number of bytes written in place into the region last acquired
+       *
+       * @param size  Number of bytes to commit
+       * @return the BulkWriter itself
+       */
+      BulkWriter &commit(std::size_t size) noexcept;
+
+      /**
+       * Write the given text verbatim
+       *
+       * @param text  Text to write
+       * @return the BulkWriter itself
+       */
+      BulkWriter &text(std::string const &text) noexcept;
+
+      /**
+       * Hand the current block over to the formatter thread, requesting the ostream to be flushed once it is written
+       *
+       * This does not wait for the block to be written.
+       *
+       * @return the BulkWriter itself
+       */
+      BulkWriter &flush() noexcept;
+
+      /**
+       * Flush, and wait for everything pending to be written
+       *
+       * @return the BulkWriter itself
+       */
+      BulkWriter &sync() noexcept;
+
+    protected:
+      /**
+       * Kind of values held in a block
+       *
+       */
+      enum class Kind : std::uint8_t {
+        Natural, Real, Bytes, Hex, Stop,
+      };
+
+      /**
+       * Block of values of a single kind
+       *
+       */
+      struct Block {
+        /**
+         * Natural values held (for Natural blocks)
+         *
+         */
+        std::vector<std::uint64_t> naturals;
+
+        /**
+         * Real values held (for Real blocks)
+         *
+         */
+        std::vector<long double> reals;
+
+        /**
+         * Terminators following each value (for Natural and Real blocks)
+         *
+         */
+        std::vector<char> terminators;
+
+        /**
+         * Bytes held (for Bytes and Hex blocks)
+         *
+         */
+        std::vector<std::uint8_t> data;
+
+        /**
+         * Number of values (or bytes) held
+         *
+         */
+        std::size_t size;
+
+        /**
+         * Kind of values held
+         *
+         */
+        Kind kind;
+
+        /**
+         * Whether to flush the ostream after writing this block
+         *
+         */
+        bool flush;
+      };
+
+      /**
+       * Retrieve the block currently being filled, making it hold values of the given kind
+       *
+       * Should the current block hold values of a different kind, or be full,
+       * it is handed over to the formatter thread first.
+       *
+       * @param kind  Kind of values to hold
+       * @return the block currently being filled
+       */
+      Block &current(Kind kind) noexcept;
+
+      /**
+       * Hand the current block over to the formatter thread, waiting for a free one to fill
+       *
+       * @param flush  Whether to flush the ostream after writing the block
+       */
+      void publish(bool flush) noexcept;
+
+      /**
+       * Wait until at most the given number of published blocks are pending formatting
+       *
+       * @param pending  Maximum number of blocks to leave pending
+       */
+      void await(std::size_t pending) noexcept;
+
+      /**
+       * Format every published block, until handed a Stop block
+       *
+       */
+      void run() noexcept;
+
+      /**
+       * Format the given block into the output buffer, writing it out as needed
+       *
+       * @param block  Block to format
+       */
+      void format(Block const &block);
+
+      /**
+       * Make room for the given number of characters in the output buffer, writing it out if needed
+       *
+       * @param size  Number of characters to make room for
+       * @return a pointer to the first free character in the output buffer
+       */
+      char *reserve(std::size_t size);
+
+      /**
+       * Write the output buffer out
+       *
+       */
+      void drain();
+
+      /**
+       * Ostream to write to
+       *
+       */
+      std::ostream &_out;
+
+      /**
+       * Ring of blocks
+       *
+       */
+      std::vector<Block> _ring;
+
+      /**
+       * Output buffer (used by the formatter thread only)
+       *
+       */
+      std::vector<char> _buffer;
+
+      /**
+       * Number of characters used in the output buffer
+       *
+       */
+      std::size_t _used;
+
+      /**
+       * Number of blocks published so far (written by the producer only)
+       *
+       */
+      std::atomic<std::size_t> _published;
+
+      /**
+       * Number of blocks formatted so far (written by the formatter thread only)
+       *
+       */
+      std::atomic<std::size_t> _formatted;
+
+      /**
+       * Mutex taken by either end of the ring in order to sleep
+       *
+       */
+      std::mutex _mutex;
+
+      /**
+       * Condition variable signalling a block being published
+       *
+       */
+      std::condition_variable _filled;
+
+      /**
+       * Condition variable signalling a block being formatted
+       *
+       */
+      std::condition_variable _freed;
+
+      /**
+       * Formatter thread
+       *
+       */
+      std::thread _thread;
+  };
+
+}
+
+#endif /* DRAUPNIR_BULK_WRITER_H__ */
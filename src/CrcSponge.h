@@ -122,7 +122,16 @@ namespace Draupnir {
        *
        * @return the squeezed out byte
        */
-      virtual std::uint8_t squeeze() noexcept override;
+      virtual std::uint8_t squeeze() noexcept override final;
+
+      /**
+       * Squeeze the given number of bytes from the sponge
+       *
+       * @param data  Byte array to squeeze into
+       * @param count  Number of bytes to squeeze
+       * @return the squeezed sponge
+       */
+      virtual CrcSponge &squeeze(std::uint8_t *data, std::size_t count) noexcept override final;
 
       /**
        * Soak a string into the sponge
@@ -228,6 +228,32 @@ namespace Draupnir {
     return _buffer[--_remaining];
   }
 
+  /**
+   * Squeeze the given number of bytes from the sponge
+   *
+   * Bytes are copied straight out of each block squeezed, in the same order
+   * as repeated single byte squeezes would yield them.
+   *
+   * @param data  Byte array to squeeze into
+   * @param count  Number of bytes to squeeze
+   * @return the squeezed sponge
+   */
+  template <typename T>
+  CrcSponge<T> &CrcSponge<T>::squeeze(std::uint8_t *data, std::size_t count) noexcept {
+    while (0 < count) {
+      if (_remaining <= 0) {
+        squeezeBlock();
+      }
+      std::size_t n = count < _remaining ? count : _remaining;
+      for (std::size_t i = 0; i < n; i++) {
+        data[i] = _buffer[--_remaining];
+      }
+      data += n;
+      count -= n;
+    }
+    return *this;
+  }
+
   /**
    * Squeeze out a single block from the sponge
    *
@@ -333,15 +359,18 @@ namespace Draupnir {
   /**
    * Apply the state-changing transformation
    *
+   * Each state word is fed to the CRC one byte at a time (ie. wordSize bytes
+   * per word, the state spanning bitSize * wordSize bytes in all).
+   *
    */
   template <typename T>
   void CrcSponge<T>::transform() noexcept {
-    static std::array<T, bitSize> temp;
+    std::array<T, bitSize> temp;
 
     // fill temporary and clear current state
     std::uint8_t const *data = reinterpret_cast<std::uint8_t const *>(_state.data());
     for (std::size_t i = 0; i < bitSize; i++) {
-      for (std::size_t k = 0; k < 8; k++) {
+      for (std::size_t k = 0; k < wordSize; k++) {
         _crc = static_cast<T>((*_crcTable.get())[(_crc ^ *(data++)) & static_cast<T>(0xff)] ^ (_crc >> 8));
       }
       temp[i] = _crc ^ _xorValue;
@@ -417,14 +446,14 @@ namespace Draupnir {
     }
 
     // verify generator
-    T generator = parseHex<std::size_t>(parts[4]);
+    T generator = parseHex<T>(parts[4]);
     if (0 == generator % 2) {
       throw std::invalid_argument("Even generator: '" + parts[4] + "'");
     }
 
     // extract xor value and initial value
-    T xorValue     = parseHex<std::size_t>(parts[5]);
-    T initialValue = parseHex<std::size_t>(parts[6]);
+    T xorValue     = parseHex<T>(parts[5]);
+    T initialValue = parseHex<T>(parts[6]);
 
     // extract initial state
     std::array<T, bitSize> initialState;
@@ -433,7 +462,7 @@ namespace Draupnir {
     }
 
     // extract current crc value
-    T crc = parseHex<std::size_t>(parts[8]);
+    T crc = parseHex<T>(parts[8]);
 
     // extract current state
     std::array<T, bitSize> state;
@@ -473,25 +502,25 @@ namespace Draupnir {
     // width
     result << std::hex << std::setw(4) << std::setfill('0') << bitSize << delim;
     // generator
-    result << std::hex << std::setw(nibbleSize) << std::setfill('0') << _generator << delim;
+    result << std::hex << std::setw(nibbleSize) << std::setfill('0') << +_generator << delim;
     // xor value
-    result << std::hex << std::setw(nibbleSize) << std::setfill('0') << _xorValue << delim;
+    result << std::hex << std::setw(nibbleSize) << std::setfill('0') << +_xorValue << delim;
     // initial value
-    result << std::hex << std::setw(nibbleSize) << std::setfill('0') << _initialValue << delim;
+    result << std::hex << std::setw(nibbleSize) << std::setfill('0') << +_initialValue << delim;
     // initial state
     for (auto row : _initialState) {
-      result << std::hex << std::setw(nibbleSize) << std::setfill('0') << row;
+      result << std::hex << std::setw(nibbleSize) << std::setfill('0') << +row;
     }
     result << delim;
     // crc
-    result << std::hex << std::setw(nibbleSize) << std::setfill('0') << _crc << delim;
+    result << std::hex << std::setw(nibbleSize) << std::setfill('0') << +_crc << delim;
     // state
     for (auto row : _state) {
-      result << std::hex << std::setw(nibbleSize) << std::setfill('0') << row;
+      result << std::hex << std::setw(nibbleSize) << std::setfill('0') << +row;
     }
     result << delim;
     // checksum
-    result << std::hex << std::setw(nibbleSize) << std::setfill('0') << ecmaCrc64(result.str());
+    result << to_hex_string(ecmaCrc64(result.str()));
 
     return result.str();
   }
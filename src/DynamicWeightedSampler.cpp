@@ -0,0 +1,173 @@
+#include "DynamicWeightedSampler.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "Random.h"
+
+
+namespace Draupnir {
+
+namespace Random {
+
+/**
+ * Construct an empty sampler
+ *
+ */
+DynamicWeightedSampler::DynamicWeightedSampler() : _capacity{1}, _count{0}, _tree(2, 0), _free{}, _removed{} {}
+
+/**
+ * Construct a sampler holding the given weights
+ *
+ * The weight at position i in the given vector will be assigned the index i.
+ *
+ * @param parts  Distribution specified as parts-to-parts
+ */
+DynamicWeightedSampler::DynamicWeightedSampler(std::vector<std::size_t> const &parts) : _capacity{1}, _count{parts.size()}, _tree{}, _free{}, _removed(parts.size(), false) {
+  while (_capacity < _count) {
+    _capacity <<= 1;
+  }
+  _tree.assign(2 * _capacity, 0);
+
+  // fill the leaves and build every internal node bottom-up
+  std::copy(parts.begin(), parts.end(), _tree.begin() + static_cast<std::ptrdiff_t>(_capacity));
+  for (std::size_t k = _capacity - 1; 0 < k; k--) {
+    _tree[k] = _tree[2 * k] + _tree[2 * k + 1];
+  }
+}
+
+
+/**
+ * Retrieve the number of indices handed out so far (including removed ones)
+ *
+ * @return the one-past-the-last index in use
+ */
+std::size_t DynamicWeightedSampler::size() const noexcept {
+  return _count;
+}
+
+/**
+ * Retrieve the sum of all the weights currently held
+ *
+ * @return the total weight
+ */
+std::size_t DynamicWeightedSampler::total() const noexcept {
+  return _tree[1];
+}
+
+/**
+ * Retrieve the weight currently associated to the given index
+ *
+ * @param i  Index to query
+ * @return the weight associated to i (0 if removed or out of range)
+ */
+std::size_t DynamicWeightedSampler::weight(std::size_t i) const noexcept {
+  return i < _count ? _tree[_capacity + i] : 0;
+}
+
+/**
+ * Add a new weight to the sampler
+ *
+ * @param w  Weight to add
+ * @return the index assigned to the new weight
+ */
+std::size_t DynamicWeightedSampler::insert(std::size_t w) {
+  std::size_t i;
+
+  if (!_free.empty()) {
+    i = _free.back();
+    _free.pop_back();
+    _removed[i] = false;
+  } else {
+    if (_count == _capacity) {
+      grow();
+    }
+    _removed.push_back(false);
+    i = _count++;
+  }
+  update(i, w);
+
+  return i;
+}
+
+/**
+ * Change the weight associated to the given index
+ *
+ * Since every ancestor of the given leaf must be adjusted by the same
+ * difference, this is simply added (in modular arithmetic) along the path to
+ * the root.
+ *
+ * @param i  Index to update
+ * @param w  New weight to adopt
+ * @return the updated DynamicWeightedSampler
+ * @throws std::invalid_argument in case the index is not in use
+ */
+DynamicWeightedSampler &DynamicWeightedSampler::update(std::size_t i, std::size_t w) {
+  if (_count <= i || _removed[i]) {
+    throw std::invalid_argument("Index not in use");
+  }
+
+  std::size_t k = _capacity + i;
+  std::size_t delta = w - _tree[k];
+
+  for (; 0 < k; k >>= 1) {
+    _tree[k] += delta;
+  }
+
+  return *this;
+}
+
+/**
+ * Remove the given index from the sampler
+ *
+ * The index will never be sampled again until reassigned by insert();
+ * removing it twice would otherwise have it handed out twice as well.
+ *
+ * @param i  Index to remove
+ * @return the updated DynamicWeightedSampler
+ * @throws std::invalid_argument in case the index is not in use
+ */
+DynamicWeightedSampler &DynamicWeightedSampler::remove(std::size_t i) {
+  update(i, 0);
+  _free.push_back(i);
+  _removed[i] = true;
+
+  return *this;
+}
+
+/**
+ * Draw an index with probability proportional to its weight - type-erased
+ *
+ * This overload merely forwards to the sponge-type-templated one.
+ *
+ * @param s  Sponge to use for randomization
+ * @return the sampled index
+ * @throws std::domain_error in case the total weight is 0
+ */
+std::size_t DynamicWeightedSampler::sample(Draupnir::Sponge &s) const {
+  return sample<Draupnir::Sponge>(s);
+}
+
+
+/**
+ * Double the tree's capacity, rebuilding its internal nodes
+ *
+ * Since the new tree's left half is exactly the old tree with its levels
+ * shifted down by one, only the new root needs to be added.
+ *
+ */
+void DynamicWeightedSampler::grow() {
+  std::vector<std::size_t> tree(4 * _capacity, 0);
+
+  for (std::size_t level = 1; level <= _capacity; level <<= 1) {
+    std::copy(_tree.begin() + static_cast<std::ptrdiff_t>(level), _tree.begin() + static_cast<std::ptrdiff_t>(2 * level), tree.begin() + static_cast<std::ptrdiff_t>(2 * level));
+  }
+  tree[1] = _tree[1];
+
+  _tree.swap(tree);
+  _capacity <<= 1;
+}
+
+}
+
+}
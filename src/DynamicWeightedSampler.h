@@ -0,0 +1,200 @@
+#ifndef DRAUPNIR_DYNAMIC_WEIGHTED_SAMPLER_H__
+#define DRAUPNIR_DYNAMIC_WEIGHTED_SAMPLER_H__
+
+#include <cstdint>
+#include <vector>
+
+#include "Sponge.h"
+
+namespace Draupnir {
+
+  namespace Random {
+
+    /**
+     * Weighted sampler supporting weight updates between draws
+     *
+     * This class maintains a collection of integral weights (specified as
+     * parts-to-parts, as in the rest of the Random namespace) in a sum tree
+     * laid out implicitly in a single contiguous array (the children of node
+     * k being 2k and 2k + 1, and the leaves starting at the capacity), so that
+     * the upper levels, visited by every operation, stay hot in cache.
+     *
+     * Updating, inserting, and removing weights, as well as sampling, all
+     * take O(log n) time; growing the underlying tree takes amortized O(1)
+     * time per insertion.
+     *
+     * Indices handed out by insert() remain stable until removed; removed
+     * indices are recycled by subsequent insertions.
+     *
+     */
+    class DynamicWeightedSampler {
+      public:
+        /**
+         * Construct an empty sampler
+         *
+         */
+        DynamicWeightedSampler();
+
+        /**
+         * Construct a sampler holding the given weights
+         *
+         * The weight at position i in the given vector will be assigned the
+         * index i.
+         *
+         * @param parts  Distribution specified as parts-to-parts
+         */
+        explicit DynamicWeightedSampler(std::vector<std::size_t> const &parts);
+
+        /**
+         * Copy constructor - defaulted
+         *
+         * @param other  DynamicWeightedSampler to copy from
+         */
+        DynamicWeightedSampler(DynamicWeightedSampler const &other) = default;
+
+        /**
+         * Move constructor - defaulted
+         *
+         * @param other  DynamicWeightedSampler to move from
+         */
+        DynamicWeightedSampler(DynamicWeightedSampler &&other) noexcept = default;
+
+        /**
+         * Assignment operator - defaulted
+         *
+         * @param other  DynamicWeightedSampler to assign
+         * @return the newly assigned DynamicWeightedSampler
+         */
+        DynamicWeightedSampler &operator=(DynamicWeightedSampler const &other) = default;
+
+        /**
+         * Move-assignment operator - defaulted
+         *
+         * @param other  DynamicWeightedSampler to move-assign
+         * @return the newly move-assigned DynamicWeightedSampler
+         */
+        DynamicWeightedSampler &operator=(DynamicWeightedSampler &&other) noexcept = default;
+
+        /**
+         * Destructor - defaulted
+         *
+         */
+        ~DynamicWeightedSampler() noexcept = default;
+
+        /**
+         * Retrieve the number of indices handed out so far (including removed ones)
+         *
+         * @return the one-past-the-last index in use
+         */
+        std::size_t size() const noexcept __attribute__((pure));
+
+        /**
+         * Retrieve the sum of all the weights currently held
+         *
+         * @return the total weight
+         */
+        std::size_t total() const noexcept __attribute__((pure));
+
+        /**
+         * Retrieve the weight currently associated to the given index
+         *
+         * @param i  Index to query
+         * @return the weight associated to i (0 if removed or out of range)
+         */
+        std::size_t weight(std::size_t i) const noexcept __attribute__((pure));
+
+        /**
+         * Add a new weight to the sampler
+         *
+         * @param w  Weight to add
+         * @return the index assigned to the new weight
+         */
+        std::size_t insert(std::size_t w);
+
+        /**
+         * Change the weight associated to the given index
+         *
+         * @param i  Index to update
+         * @param w  New weight to adopt
+         * @return the updated DynamicWeightedSampler
+         * @throws std::invalid_argument in case the index is not in use
+         */
+        DynamicWeightedSampler &update(std::size_t i, std::size_t w);
+
+        /**
+         * Remove the given index from the sampler
+         *
+         * The index will never be sampled again until reassigned by insert().
+         *
+         * @param i  Index to remove
+         * @return the updated DynamicWeightedSampler
+         * @throws std::invalid_argument in case the index is not in use
+         */
+        DynamicWeightedSampler &remove(std::size_t i);
+
+        /**
+         * Draw an index with probability proportional to its weight
+         *
+         * @param s  Sponge to use for randomization
+         * @return the sampled index
+         * @throws std::domain_error in case the total weight is 0
+         */
+        template <typename S>
+        std::size_t sample(S &s) const;
+
+        /**
+         * Draw an index with probability proportional to its weight - type-erased
+         *
+         * This overload merely forwards to the sponge-type-templated one.
+         *
+         * @param s  Sponge to use for randomization
+         * @return the sampled index
+         * @throws std::domain_error in case the total weight is 0
+         */
+        std::size_t sample(Draupnir::Sponge &s) const;
+
+      protected:
+        /**
+         * Double the tree's capacity, rebuilding its internal nodes
+         *
+         */
+        void grow();
+
+        /**
+         * Number of leaves in the tree (always a power of 2)
+         *
+         */
+        std::size_t _capacity;
+
+        /**
+         * Number of indices handed out so far
+         *
+         */
+        std::size_t _count;
+
+        /**
+         * Implicit sum tree (node 0 unused, root at 1, leaves at _capacity onwards)
+         *
+         */
+        std::vector<std::size_t> _tree;
+
+        /**
+         * Removed indices available for reuse
+         *
+         */
+        std::vector<std::size_t> _free;
+
+        /**
+         * Whether each index handed out so far is currently removed
+         *
+         */
+        std::vector<bool> _removed;
+    };
+
+  }
+
+}
+
+#include "DynamicWeightedSampler.hpp"
+
+#endif /* DRAUPNIR_DYNAMIC_WEIGHTED_SAMPLER_H__ */
@@ -0,0 +1,47 @@
+#ifndef DRAUPNIR_DYNAMIC_WEIGHTED_SAMPLER_HPP__
+#define DRAUPNIR_DYNAMIC_WEIGHTED_SAMPLER_HPP__
+
+#include <stdexcept>
+
+#include "DynamicWeightedSampler.h"
+#include "Random.h"
+
+namespace Draupnir {
+
+  namespace Random {
+
+    /**
+     * Draw an index with probability proportional to its weight
+     *
+     * A single natural number below the total weight is drawn, and the tree
+     * is descended from the root towards the leaf whose cumulative range
+     * contains it.
+     *
+     * @param s  Sponge to use for randomization
+     * @return the sampled index
+     * @throws std::domain_error in case the total weight is 0
+     */
+    template <typename S>
+    std::size_t DynamicWeightedSampler::sample(S &s) const {
+      if (0 == _tree[1]) {
+        throw std::domain_error("Empty distribution");
+      }
+
+      std::size_t r = natural<std::size_t>(s, _tree[1] - 1);
+      std::size_t k = 1;
+      while (k < _capacity) {
+        k <<= 1;
+        if (_tree[k] <= r) {
+          r -= _tree[k];
+          k++;
+        }
+      }
+
+      return k - _capacity;
+    }
+
+  }
+
+}
+
+#endif /* DRAUPNIR_DYNAMIC_WEIGHTED_SAMPLER_HPP__ */
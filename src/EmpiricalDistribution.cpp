@@ -0,0 +1,213 @@
+#include "EmpiricalDistribution.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "Random.h"
+
+
+namespace {
+
+/**
+ * Check that the given points are strictly increasing and match the given number of values
+ *
+ * @param points  Points to check
+ * @param count  Number of values expected (one per point)
+ * @param what  Name of the values to report on failure
+ * @throws std::invalid_argument in case the points given are inconsistent
+ */
+void checkPoints(std::vector<double> const &points, std::size_t count, std::string const &what) {
+  if (points.size() < 2 || points.size() != count) {
+    throw std::invalid_argument("Expected at least two points and as many " + what);
+  }
+  for (std::size_t i = 1; i < points.size(); i++) {
+    if (!(points[i - 1] < points[i])) {
+      throw std::invalid_argument("Points must be strictly increasing");
+    }
+  }
+}
+
+}
+
+namespace Draupnir {
+
+namespace Random {
+
+/**
+ * Build a piecewise-constant distribution from a histogram
+ *
+ * @param edges  Bin edges (one more than weights, strictly increasing)
+ * @param weights  Bin weights (non-negative, not necessarily normalized)
+ * @return the EmpiricalDistribution built
+ * @throws std::invalid_argument in case the edges and weights given are inconsistent
+ * @throws std::domain_error in case the total weight is 0
+ */
+EmpiricalDistribution EmpiricalDistribution::histogram(std::vector<double> const &edges, std::vector<double> const &weights) {
+  checkPoints(edges, weights.size() + 1, "weights (plus one)");
+  for (double w : weights) {
+    if (!(0.0 <= w)) {
+      throw std::invalid_argument("Weights must be non-negative");
+    }
+  }
+  return EmpiricalDistribution(std::vector<double>(edges), weights, std::vector<double>());
+}
+
+/**
+ * Build a piecewise-constant distribution from a CDF table
+ *
+ * Each bin's mass is the difference between the CDF values at its edges.
+ *
+ * @param points  Points the CDF is given at (strictly increasing)
+ * @param cdf  CDF values at each point (non-decreasing, not necessarily normalized)
+ * @return the EmpiricalDistribution built
+ * @throws std::invalid_argument in case the points and values given are inconsistent
+ * @throws std::domain_error in case the CDF is constant
+ */
+EmpiricalDistribution EmpiricalDistribution::cdfTable(std::vector<double> const &points, std::vector<double> const &cdf) {
+  checkPoints(points, cdf.size(), "CDF values");
+  std::vector<double> masses(cdf.size() - 1);
+  for (std::size_t i = 0; i < masses.size(); i++) {
+    masses[i] = cdf[i + 1] - cdf[i];
+    if (!(0.0 <= masses[i])) {
+      throw std::invalid_argument("CDF values must be non-decreasing");
+    }
+  }
+  return EmpiricalDistribution(std::vector<double>(points), masses, std::vector<double>());
+}
+
+/**
+ * Build a piecewise-linear distribution from a density table
+ *
+ * Each bin's mass is given by the trapezoidal rule (which is exact for
+ * linear densities).
+ *
+ * @param points  Points the density is given at (strictly increasing)
+ * @param densities  Density values at each point (non-negative, not necessarily normalized)
+ * @return the EmpiricalDistribution built
+ * @throws std::invalid_argument in case the points and values given are inconsistent
+ * @throws std::domain_error in case the density is identically 0
+ */
+EmpiricalDistribution EmpiricalDistribution::densityTable(std::vector<double> const &points, std::vector<double> const &densities) {
+  checkPoints(points, densities.size(), "densities");
+  for (double d : densities) {
+    if (!(0.0 <= d)) {
+      throw std::invalid_argument("Densities must be non-negative");
+    }
+  }
+  std::vector<double> masses(densities.size() - 1);
+  for (std::size_t i = 0; i < masses.size(); i++) {
+    masses[i] = (densities[i] + densities[i + 1]) / 2.0 * (points[i + 1] - points[i]);
+  }
+  return EmpiricalDistribution(std::vector<double>(points), masses, std::vector<double>(densities));
+}
+
+/**
+ * Retrieve the number of bins in the distribution
+ *
+ * @return the number of bins
+ */
+std::size_t EmpiricalDistribution::bins() const noexcept {
+  return _table.size();
+}
+
+/**
+ * Draw a value from the distribution - type-erased
+ *
+ * This overload merely forwards to the sponge-type-templated one.
+ *
+ * @param s  Sponge to use for randomization
+ * @return the value drawn
+ */
+double EmpiricalDistribution::sample(Draupnir::Sponge &s) const {
+  return sample<Draupnir::Sponge>(s);
+}
+
+/**
+ * Fill the given range with values drawn from the distribution - type-erased
+ *
+ * This overload merely forwards to the sponge-type-templated one.
+ *
+ * @param s  Sponge to use for randomization
+ * @param first  Pointer to the first element to fill
+ * @param last  Pointer past the last element to fill
+ */
+void EmpiricalDistribution::sample(Draupnir::Sponge &s, double *first, double *last) const {
+  sample<Draupnir::Sponge>(s, first, last);
+}
+
+/**
+ * Main constructor
+ *
+ * The alias table is built using Vose's method over the bins' masses.
+ *
+ * @param edges  Bin edges (one more than bins, strictly increasing)
+ * @param masses  Bin masses (non-negative, not necessarily normalized)
+ * @param densities  Density values at each edge (empty for piecewise-constant densities)
+ * @throws std::domain_error in case the total mass is 0
+ */
+EmpiricalDistribution::EmpiricalDistribution(std::vector<double> &&edges, std::vector<double> const &masses, std::vector<double> &&densities) : _edges{std::move(edges)}, _densities{std::move(densities)}, _table(masses.size()) {
+  double total = 0.0;
+  for (double m : masses) {
+    total += m;
+  }
+  if (!(0.0 < total)) {
+    throw std::domain_error("Empty distribution");
+  }
+
+  std::size_t n = masses.size();
+  std::vector<double> scaled(n);
+  std::vector<std::size_t> small, large;
+  for (std::size_t i = 0; i < n; i++) {
+    scaled[i] = masses[i] * static_cast<double>(n) / total;
+    (scaled[i] < 1.0 ? small : large).push_back(i);
+  }
+
+  while (!small.empty() && !large.empty()) {
+    std::size_t l = small.back(), g = large.back();
+    small.pop_back();
+    _table[l] = Entry{scaled[l], g};
+    scaled[g] = (scaled[g] + scaled[l]) - 1.0;
+    if (scaled[g] < 1.0) {
+      large.pop_back();
+      small.push_back(g);
+    }
+  }
+  for (std::size_t i : large) {
+    _table[i] = Entry{1.0, i};
+  }
+  for (std::size_t i : small) {
+    _table[i] = Entry{1.0, i};
+  }
+}
+
+/**
+ * Locate a value within the given bin
+ *
+ * For linear densities, going from fa to fb across the bin, the CDF within
+ * the bin at relative position t is proportional to fa t + (fb - fa) t^2 / 2,
+ * which is inverted in its numerically stable form
+ * t = u (fa + fb) / (fa + sqrt(fa^2 + (fb^2 - fa^2) u)), valid for flat and
+ * vanishing densities alike.
+ *
+ * @param bin  Bin to locate the value in
+ * @param u  Position within the bin's mass (between 0 and 1)
+ * @return the value located
+ */
+double EmpiricalDistribution::locate(std::size_t bin, double u) const noexcept {
+  double a = _edges[bin], b = _edges[bin + 1];
+  if (_densities.empty()) {
+    return a + u * (b - a);
+  }
+
+  double fa = _densities[bin], fb = _densities[bin + 1];
+  double denominator = fa + std::sqrt(fa * fa + (fb * fb - fa * fa) * u);
+  double t = 0.0 < denominator ? std::min(1.0, u * (fa + fb) / denominator) : u;
+  return a + t * (b - a);
+}
+
+}
+
+}
@@ -0,0 +1,211 @@
+#ifndef DRAUPNIR_EMPIRICAL_DISTRIBUTION_H__
+#define DRAUPNIR_EMPIRICAL_DISTRIBUTION_H__
+
+#include <cstdint>
+#include <vector>
+
+#include "Sponge.h"
+
+namespace Draupnir {
+
+  namespace Random {
+
+    /**
+     * Sampler for continuous distributions given as histograms or CDF tables
+     *
+     * This class represents a distribution over a sequence of contiguous
+     * bins, its density being either constant or linear within each bin
+     * (ie. piecewise-constant or piecewise-linear densities); an alias table
+     * is built over the bins' masses, so that sampling takes O(1) time: a
+     * single natural number selects a bin's alias table entry, and a single
+     * real value both decides between the bin and its alias and, rescaled,
+     * locates the sample within the chosen bin (by inverting the bin's
+     * uniform or linear density).
+     *
+     * Named constructors are provided for histograms (piecewise-constant),
+     * CDF tables (likewise piecewise-constant, interpolating the CDF
+     * linearly), and density tables (piecewise-linear).
+     *
+     */
+    class EmpiricalDistribution {
+      public:
+        /**
+         * Build a piecewise-constant distribution from a histogram
+         *
+         * @param edges  Bin edges (one more than weights, strictly increasing)
+         * @param weights  Bin weights (non-negative, not necessarily normalized)
+         * @return the EmpiricalDistribution built
+         * @throws std::invalid_argument in case the edges and weights given are inconsistent
+         * @throws std::domain_error in case the total weight is 0
+         */
+        static EmpiricalDistribution histogram(std::vector<double> const &edges, std::vector<double> const &weights);
+
+        /**
+         * Build a piecewise-constant distribution from a CDF table
+         *
+         * @param points  Points the CDF is given at (strictly increasing)
+         * @param cdf  CDF values at each point (non-decreasing, not necessarily normalized)
+         * @return the EmpiricalDistribution built
+         * @throws std::invalid_argument in case the points and values given are inconsistent
+         * @throws std::domain_error in case the CDF is constant
+         */
+        static EmpiricalDistribution cdfTable(std::vector<double> const &points, std::vector<double> const &cdf);
+
+        /**
+         * Build a piecewise-linear distribution from a density table
+         *
+         * @param points  Points the density is given at (strictly increasing)
+         * @param densities  Density values at each point (non-negative, not necessarily normalized)
+         * @return the EmpiricalDistribution built
+         * @throws std::invalid_argument in case the points and values given are inconsistent
+         * @throws std::domain_error in case the density is identically 0
+         */
+        static EmpiricalDistribution densityTable(std::vector<double> const &points, std::vector<double> const &densities);
+
+        /**
+         * Copy constructor - defaulted
+         *
+         * @param other  EmpiricalDistribution to copy from
+         */
+        EmpiricalDistribution(EmpiricalDistribution const &other) = default;
+
+        /**
+         * Move constructor - defaulted
+         *
+         * @param other  EmpiricalDistribution to move from
+         */
+        EmpiricalDistribution(EmpiricalDistribution &&other) noexcept = default;
+
+        /**
+         * Assignment operator - defaulted
+         *
+         * @param other  EmpiricalDistribution to assign
+         * @return the newly assigned EmpiricalDistribution
+         */
+        EmpiricalDistribution &operator=(EmpiricalDistribution const &other) = default;
+
+        /**
+         * Move-assignment operator - defaulted
+         *
+         * @param other  EmpiricalDistribution to move-assign
+         * @return the newly move-assigned EmpiricalDistribution
+         */
+        EmpiricalDistribution &operator=(EmpiricalDistribution &&other) noexcept = default;
+
+        /**
+         * Destructor - defaulted
+         *
+         */
+        ~EmpiricalDistribution() noexcept = default;
+
+        /**
+         * Retrieve the number of bins in the distribution
+         *
+         * @return the number of bins
+         */
+        std::size_t bins() const noexcept __attribute__((pure));
+
+        /**
+         * Draw a value from the distribution
+         *
+         * @param s  Sponge to use for randomization
+         * @return the value drawn
+         */
+        template <typename S>
+        double sample(S &s) const;
+
+        /**
+         * Draw a value from the distribution - type-erased
+         *
+         * This overload merely forwards to the sponge-type-templated one.
+         *
+         * @param s  Sponge to use for randomization
+         * @return the value drawn
+         */
+        double sample(Draupnir::Sponge &s) const;
+
+        /**
+         * Fill the given range with values drawn from the distribution
+         *
+         * @param s  Sponge to use for randomization
+         * @param first  Pointer to the first element to fill
+         * @param last  Pointer past the last element to fill
+         */
+        template <typename S>
+        void sample(S &s, double *first, double *last) const;
+
+        /**
+         * Fill the given range with values drawn from the distribution - type-erased
+         *
+         * This overload merely forwards to the sponge-type-templated one.
+         *
+         * @param s  Sponge to use for randomization
+         * @param first  Pointer to the first element to fill
+         * @param last  Pointer past the last element to fill
+         */
+        void sample(Draupnir::Sponge &s, double *first, double *last) const;
+
+      protected:
+        /**
+         * Alias table entry
+         *
+         */
+        struct Entry {
+          /**
+           * Probability of keeping the entry's own bin
+           *
+           */
+          double probability;
+
+          /**
+           * Bin to take otherwise
+           *
+           */
+          std::size_t alias;
+        };
+
+        /**
+         * Main constructor
+         *
+         * @param edges  Bin edges (one more than bins, strictly increasing)
+         * @param masses  Bin masses (non-negative, not necessarily normalized)
+         * @param densities  Density values at each edge (empty for piecewise-constant densities)
+         * @throws std::domain_error in case the total mass is 0
+         */
+        EmpiricalDistribution(std::vector<double> &&edges, std::vector<double> const &masses, std::vector<double> &&densities);
+
+        /**
+         * Locate a value within the given bin
+         *
+         * @param bin  Bin to locate the value in
+         * @param u  Position within the bin's mass (between 0 and 1)
+         * @return the value located
+         */
+        double locate(std::size_t bin, double u) const noexcept __attribute__((pure));
+
+        /**
+         * Bin edges
+         *
+         */
+        std::vector<double> _edges;
+
+        /**
+         * Density values at each edge (empty for piecewise-constant densities)
+         *
+         */
+        std::vector<double> _densities;
+
+        /**
+         * Alias table over the bins
+         *
+         */
+        std::vector<Entry> _table;
+    };
+
+  }
+
+}
+
+#include "EmpiricalDistribution.hpp"
+
+#endif /* DRAUPNIR_EMPIRICAL_DISTRIBUTION_H__ */
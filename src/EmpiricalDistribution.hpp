@@ -0,0 +1,53 @@
+#ifndef DRAUPNIR_EMPIRICAL_DISTRIBUTION_HPP__
+#define DRAUPNIR_EMPIRICAL_DISTRIBUTION_HPP__
+
+#include "EmpiricalDistribution.h"
+#include "Random.h"
+
+namespace Draupnir {
+
+  namespace Random {
+
+    /**
+     * Draw a value from the distribution
+     *
+     * The real value drawn is compared against the entry's probability, and
+     * the part of the unit interval it falls in is then rescaled to the unit
+     * interval once again, so as to locate the value within the chosen bin.
+     *
+     * @param s  Sponge to use for randomization
+     * @return the value drawn
+     */
+    template <typename S>
+    double EmpiricalDistribution::sample(S &s) const {
+      std::size_t i = natural<std::size_t>(s, _table.size() - 1);
+      double u = openReal(s);
+      Entry const &entry = _table[i];
+      if (u < entry.probability) {
+        return locate(i, u / entry.probability);
+      }
+      return locate(entry.alias, (u - entry.probability) / (1.0 - entry.probability));
+    }
+
+    /**
+     * Fill the given range with values drawn from the distribution
+     *
+     * The sponge type being known, every draw in the loop is dispatched
+     * statically.
+     *
+     * @param s  Sponge to use for randomization
+     * @param first  Pointer to the first element to fill
+     * @param last  Pointer past the last element to fill
+     */
+    template <typename S>
+    void EmpiricalDistribution::sample(S &s, double *first, double *last) const {
+      for (; first != last; ++first) {
+        *first = sample<S>(s);
+      }
+    }
+
+  }
+
+}
+
+#endif /* DRAUPNIR_EMPIRICAL_DISTRIBUTION_HPP__ */
@@ -1,23 +1,184 @@
 #include "Environment.h"
 
 #include <algorithm>
-#include <iomanip>
+#include <cmath>
+#include <cstring>
 #include <limits>
-#include <fstream>
-#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
 
+#include "LineReader.h"
 #include "Random.h"
 
 
+namespace {
+
+/**
+ * Number of bytes squeezed at a time when generating raw bytes
+ *
+ */
+constexpr std::size_t rawBlockSize = std::size_t(1) << 12;
+
+/**
+ * Number of bytes squeezed from the seeder when reseeding (enough to cover a 64-bit CrcSponge's whole state)
+ *
+ */
+constexpr std::size_t reseedBlockSize = 64 * 8;
+
+/**
+ * Minimum total work (in transformation steps) for a multi-Sponge command to be run on the thread pool
+ *
+ * Below this, waking the pool up costs more than the work itself.
+ *
+ */
+constexpr std::size_t parallelWorkThreshold = 256;
+
+/**
+ * Write the given natural as decimal text, on a line of its own
+ *
+ * @param writer  BulkWriter to write to
+ * @param value  Value to write
+ */
+void writeText(Draupnir::BulkWriter &writer, std::uint64_t value) noexcept {
+  writer.natural(value);
+}
+
+/**
+ * Write the given real as decimal text, on a line of its own
+ *
+ * @param writer  BulkWriter to write to
+ * @param value  Value to write
+ */
+void writeText(Draupnir::BulkWriter &writer, long double value) noexcept {
+  writer.real(value);
+}
+
+/**
+ * Store the given unsigned integer in little-endian order
+ *
+ * @param out  Pointer to the bytes to store into
+ * @param value  Value to store
+ */
+template <typename T>
+void storeLittleEndian(std::uint8_t *out, T value) noexcept {
+  for (std::size_t i = 0; i < sizeof(T); i++) {
+    out[i] = static_cast<std::uint8_t>(value >> (8 * i));
+  }
+}
+
+/**
+ * Store the given double in little-endian order (assuming IEEE 754 doubles)
+ *
+ * @param out  Pointer to the bytes to store into
+ * @param value  Value to store
+ */
+void storeLittleEndian(std::uint8_t *out, double value) noexcept {
+  std::uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  storeLittleEndian(out, bits);
+}
+
+/**
+ * Convert the given natural to the given binary output type
+ *
+ * Naturals are truncated to the type's width, if needed.
+ *
+ * @param value  Value to convert
+ * @return the converted value
+ */
+template <typename E>
+E binaryValue(std::uint64_t value) noexcept {
+  return static_cast<E>(value);
+}
+
+/**
+ * Convert the given real to the given binary output type
+ *
+ * Reals are converted as is for floating point types; for integral types,
+ * they are rounded to the nearest integer and clamped to the type's range
+ * (negative values and NaN mapping to 0), since converting an out-of-range
+ * value directly is undefined.
+ *
+ * @param value  Value to convert
+ * @return the converted value
+ */
+template <typename E>
+E binaryValue(long double value) noexcept {
+  if (std::is_floating_point<E>::value) {
+    return static_cast<E>(value);
+  }
+  if (!(0.0l < value)) {
+    return E(0);
+  }
+  long double rounded = std::round(value);
+  if (static_cast<long double>(std::numeric_limits<E>::max()) <= rounded) {
+    return std::numeric_limits<E>::max();
+  }
+  return static_cast<E>(rounded);
+}
+
+/**
+ * Write the given number of values, as produced by the given generator, as little-endian values of the given type
+ *
+ * Values are generated directly into the regions acquired from the writer.
+ *
+ * @param writer  BulkWriter to write to
+ * @param count  Number of values to write
+ * @param generate  Generator to call for each value
+ */
+template <typename E, typename G>
+void writeBinary(Draupnir::BulkWriter &writer, std::size_t count, G const &generate) noexcept {
+  while (0 < count) {
+    std::size_t available;
+    std::uint8_t *out = writer.acquire(sizeof(E), available);
+    std::size_t n = std::min(count, available / sizeof(E));
+    for (std::size_t i = 0; i < n; i++) {
+      storeLittleEndian(out + i * sizeof(E), binaryValue<E>(generate()));
+    }
+    writer.commit(n * sizeof(E));
+    count -= n;
+  }
+}
+
+/**
+ * Build a NumPy .npy (version 1.0) header for a C-ordered array of the given type and shape
+ *
+ * The header is padded so that the data following it is 64-byte aligned.
+ *
+ * @param descr  NumPy type descriptor
+ * @param rows  Number of rows
+ * @param columns  Number of columns (0 for a one-dimensional array)
+ * @return the header built
+ */
+std::string npyHeader(std::string const &descr, std::size_t rows, std::size_t columns) {
+  std::string dict = "{'descr': '" + descr + "', 'fortran_order': False, 'shape': (" + std::to_string(rows) + (0 == columns ? std::string(",") : ", " + std::to_string(columns)) + "), }";
+  dict.append(63 - (10 + dict.size()) % 64, ' ');
+  dict += '\n';
+
+  std::string header("\x93NUMPY\x01\x00", 8);
+  header += static_cast<char>(dict.size() & 0xff);
+  header += static_cast<char>(dict.size() >> 8);
+  return header + dict;
+}
+
+}
+
 namespace Draupnir {
 
 /**
  * Construct a new execution environment
  *
+ * Output is written through a BulkWriter, and multi-Sponge commands are
+ * run on a ThreadPool, both shared among copies of the Environment, which
+ * must thus not be used concurrently.
+ *
  * @param out  Ostream to use for output
  * @param err  Ostream to use for errors
+ * @param threads  Number of threads to use for multi-Sponge commands (0 to use the hardware concurrency)
+ * @throws std::system_error in case the output formatting thread or the worker threads cannot be started
  */
-Environment::Environment(std::ostream &out, std::ostream &err) noexcept : stack{}, sout{out}, serr{err} {}
+Environment::Environment(std::ostream &out, std::ostream &err, std::size_t threads) : stack{}, sout{out}, serr{err}, pool{std::make_shared<ThreadPool>(threads)}, writer{std::make_shared<BulkWriter>(out)}, outputFormat{Format::Text}, outputNpy{false} {}
 
 
 /**
@@ -27,10 +188,7 @@ Environment::Environment(std::ostream &out, std::ostream &err) noexcept : stack{
  * @return the resulting Environment
  */
 Environment &Environment::drop(std::size_t n) noexcept {
-  std::size_t nn = std::max(0ul, std::min(stack.size(), n));
-  if (0 != nn) {
-    stack.erase(stack.end() - static_cast<stack_offset_type>(nn), stack.end());
-  }
+  stack.drop(n);
   return *this;
 }
 
@@ -42,14 +200,7 @@ Environment &Environment::drop(std::size_t n) noexcept {
  * @return the resulting Environment
  */
 Environment &Environment::copy(std::size_t n, std::size_t m) noexcept {
-  std::size_t mm = std::max(0ul, std::min(stack.size(), m));
-  if (0 != mm) {
-    for (std::size_t i = 0; i < n; i++) {
-      for (std::size_t j = 0; j < mm; j++) {
-        stack.push_back(value_ptr<Sponge>(stack[stack.size() - mm + j]->clone()));
-      }
-    }
-  }
+  stack.copy(n, m);
   return *this;
 }
 
@@ -61,21 +212,28 @@ Environment &Environment::copy(std::size_t n, std::size_t m) noexcept {
  * @return the resulting Environment
  */
 Environment &Environment::sink(std::size_t n, std::size_t m) noexcept {
-  n = std::min(n, stack.size());
-  m = std::min(m, stack.size() - n);
-
-  if (0 != n && 0 != m) {
-    std::rotate(
-        stack.end() - static_cast<stack_offset_type>(n + m),
-        stack.end() - static_cast<stack_offset_type>(n    ),
-        stack.end()
-    );
-  }
-
+  stack.sink(n, m);
   return *this;
 }
 
 
+/**
+ * Set the output format to use for numeric commands
+ *
+ * Binary formats write each value in little-endian order, converted to the
+ * given type (naturals being truncated and reals rounded as needed).
+ *
+ * @param format  Format to use (either decimal text, or little-endian binary values of the given type)
+ * @param npy  Whether to precede each command's binary output with a NumPy .npy header
+ * @return the resulting Environment
+ */
+Environment &Environment::output(Format format, bool npy) noexcept {
+  outputFormat = format;
+  outputNpy = npy;
+
+  return *this;
+}
+
 /**
  * Generate the given number of raw bytes from the topmost Sponge
  *
@@ -84,100 +242,124 @@ Environment &Environment::sink(std::size_t n, std::size_t m) noexcept {
  * @return the resulting Environment
  */
 Environment &Environment::raw(std::size_t count, bool hex) noexcept {
-  std::ios::fmtflags flags(sout.flags());
-  sout << std::setw(0);
-  if (hex) { sout << std::hex; }
-  while (count--) {
-    sout << stack.back()->squeeze();
-  }
-  sout.flags(flags);
+  stack.top([this, &count, &hex](auto &s) {
+    std::uint8_t block[rawBlockSize];
+    while (0 < count) {
+      std::size_t n = std::min(count, rawBlockSize);
+      s.squeeze(block, n);
+      if (hex) {
+        writer->hex(block, n);
+      } else {
+        writer->bytes(block, n);
+      }
+      count -= n;
+    }
+  });
+  writer->flush();
 
   return *this;
 }
 
 /**
- * Generate a natural number from 0 to the number given
+ * Generate the given number of natural numbers from 0 to the number given
  *
  * @param high  Maximum number to generate
+ * @param count  Number of naturals to generate
  * @return the resulting Environment
  */
-Environment &Environment::natural(std::size_t high) noexcept {
-  std::ios::fmtflags flags(sout.flags());
-  sout << std::setw(0) << std::dec << Random::natural<std::uint64_t>(*stack.back(), high) << std::endl;
-  sout.flags(flags);
+Environment &Environment::natural(std::size_t high, std::size_t count) noexcept {
+  stack.top([this, high, count](auto &s) {
+    writeHeader(count);
+    writeValues(count, [&s, high]() { return Random::natural<std::uint64_t>(s, high); });
+  });
+  writer->flush();
 
   return *this;
 }
 
 /**
- * Generate a real number from 0.0 o the number given
+ * Generate the given number of real numbers from 0.0 to the number given
  *
  * @param high  Maximum number to generate
+ * @param count  Number of reals to generate
  * @return the resulting Environment
  */
-Environment &Environment::real(long double high) noexcept {
-  std::ios::fmtflags flags(sout.flags());
-  sout << std::fixed
-       << std::setw(0)
-       << std::setprecision(std::numeric_limits<long double>::digits10 + 1)
-       << std::dec
-       << (Random::real(*stack.back()) * high)
-       << std::endl;
-  sout.flags(flags);
+Environment &Environment::real(long double high, std::size_t count) noexcept {
+  stack.top([this, &high, count](auto &s) {
+    writeHeader(count);
+    writeValues(count, [&s, &high]() { return Random::real(s) * high; });
+  });
+  writer->flush();
 
   return *this;
 }
 
 /**
- * Generate a permutation of the numbers between 0 and the given number
+ * Generate the given number of permutations of the numbers between 0 and the given number
  *
  * @param highElem  Highest element to permute
+ * @param count  Number of permutations to generate
  * @return the resulting Environment
  */
-Environment &Environment::permutation(std::size_t highElem) noexcept {
-  std::ios::fmtflags flags(sout.flags());
-  sout << std::setw(0) << std::dec;
-  for (std::size_t x : Random::permutation(*stack.back(), highElem)) {
-    sout << x << " ";
-  }
-  sout << std::endl;
-  sout.flags(flags);
+Environment &Environment::permutation(std::size_t highElem, std::size_t count) noexcept {
+  stack.top([this, highElem, count](auto &s) {
+    writeHeader(count, highElem);
+    for (std::size_t i = 0; i < count; i++) {
+      writeList(Random::permutation(s, highElem));
+    }
+  });
+  writer->flush();
 
   return *this;
 }
 
 /**
- * Generate a cycle of the numbers between 0 and the given number
+ * Generate the given number of cycles of the numbers between 0 and the given number
  *
  * @param highElem  Highest element to permute
+ * @param count  Number of cycles to generate
  * @return the resulting Environment
  */
-Environment &Environment::cycle(std::size_t highElem) noexcept {
-  std::ios::fmtflags flags(sout.flags());
-  sout << std::setw(0) << std::dec;
-  for (std::size_t x : Random::cycle(*stack.back(), highElem)) {
-    sout << x << " ";
-  }
-  sout << std::endl;
-  sout.flags(flags);
+Environment &Environment::cycle(std::size_t highElem, std::size_t count) noexcept {
+  stack.top([this, highElem, count](auto &s) {
+    writeHeader(count, highElem);
+    for (std::size_t i = 0; i < count; i++) {
+      writeList(Random::cycle(s, highElem));
+    }
+  });
+  writer->flush();
 
   return *this;
 }
 
 /**
- * Generate a derangement of the numbers between 0 and the given number
+ * Generate the given number of derangements of the numbers between 0 and the given number
  *
  * @param highElem  Highest element to permute
+ * @param count  Number of derangements to generate
  * @return the resulting Environment
  */
-Environment &Environment::derangement(std::size_t highElem) noexcept {
-  std::ios::fmtflags flags(sout.flags());
-  sout << std::setw(0) << std::dec;
-  for (std::size_t x : Random::derangement(*stack.back(), highElem)) {
-    sout << x << " ";
-  }
-  sout << std::endl;
-  sout.flags(flags);
+Environment &Environment::derangement(std::size_t highElem, std::size_t count) noexcept {
+  stack.top([this, highElem, count](auto &s) {
+    std::vector<std::size_t> d;
+    try {
+      if (0 < count) {
+        d = Random::derangement(s, highElem);
+      }
+    } catch (std::domain_error const &) {
+      // no derangement of a single element: write nothing
+      return;
+    }
+
+    writeHeader(count, highElem);
+    for (std::size_t i = 0; i < count; i++) {
+      if (0 < i) {
+        d = Random::derangement(s, highElem);
+      }
+      writeList(d);
+    }
+  });
+  writer->flush();
 
   return *this;
 }
@@ -191,30 +373,35 @@ Environment &Environment::derangement(std::size_t highElem) noexcept {
  * @param replacements  Whether to allow replacements or not
  * @return the resulting Environment
  */
-Environment &Environment::sample(std::size_t count, std::size_t highElem, std::vector<std::size_t> parts, bool replacements) noexcept {
+Environment &Environment::sample(std::size_t count, std::size_t highElem, std::vector<std::size_t> const &parts, bool replacements) noexcept {
   std::vector<std::size_t> s;
 
-  if (replacements) {
-    if (parts.empty()) {
-      s = Random::uniformSampleWithReplacement(*stack.back(), highElem, count);
-    } else {
-      s = Random::nonUniformSampleWithReplacement(*stack.back(), parts, count);
-    }
-  } else {
-    if (parts.empty()) {
-      s = Random::uniformSampleWithoutReplacement(*stack.back(), highElem, count);
-    } else {
-      s = Random::nonUniformSampleWithoutReplacement(*stack.back(), parts, count);
+  stack.top([&](auto &sponge) {
+    try {
+      if (replacements) {
+        if (parts.empty()) {
+          s = Random::uniformSampleWithReplacement(sponge, highElem, count);
+        } else {
+          s = Random::nonUniformSampleWithReplacement(sponge, parts, count);
+        }
+      } else {
+        if (parts.empty()) {
+          s = Random::uniformSampleWithoutReplacement(sponge, highElem, count);
+        } else {
+          s = Random::nonUniformSampleWithoutReplacement(sponge, parts, count);
+        }
+      }
+    } catch (std::domain_error const &) {
+      // nothing to sample from: yield an empty sample
+      s.clear();
     }
-  }
+  });
 
-  std::ios::fmtflags flags(sout.flags());
-  sout << std::setw(0) << std::dec;
-  for (std::size_t x : s) {
-    sout << x << " ";
+  if (!stack.empty()) {
+    writeHeader(s.size());
+    writeList(s);
   }
-  sout << std::endl;
-  sout.flags(flags);
+  writer->flush();
 
   return *this;
 }
@@ -226,8 +413,9 @@ Environment &Environment::sample(std::size_t count, std::size_t highElem, std::v
  * @param state  State to unserialize
  * @return the resulting Environment
  */
-Environment &Environment::load(std::string &state) {
-  // ???
+Environment &Environment::load(std::string const &state) {
+  stack.load(state);
+  return *this;
 }
 
 /**
@@ -237,12 +425,13 @@ Environment &Environment::load(std::string &state) {
  * @param count  Number of lines to deserialize (all if 0)
  * @return the resulting Environment
  */
-Environment &Environment::open(std::string &file, std::size_t count) {
-  std::ifstream input(file);
-  std::string line;
+Environment &Environment::open(std::string const &file, std::size_t count) {
+  LineReader input(file);
+  char const *line;
+  std::size_t length;
 
-  while (std::getline(input, line)) {
-    load(line);
+  for (std::size_t i = 0; (0 == count || i < count) && input.next(line, length); i++) {
+    load(std::string(line, length));
   }
 
   return *this;
@@ -255,9 +444,7 @@ Environment &Environment::open(std::string &file, std::size_t count) {
  * @return the resulting Environment
  */
 Environment &Environment::reset(std::size_t n) noexcept {
-  n = std::min(n, stack.size());
-
-  std::for_each(stack.rbegin(), stack.rbegin() + static_cast<stack_offset_type>(n), [](auto &x){ x->reset(); });
+  stack.top(n, [](auto &x){ x.reset(); }, poolFor(n, 0));
 
   return *this;
 }
@@ -269,24 +456,43 @@ Environment &Environment::reset(std::size_t n) noexcept {
  * @param n  Number of Sponges to soak
  * @return the resulting Environment
  */
-Environment &Environment::soak(std::string &data, std::size_t n) noexcept {
-  n = std::min(n, stack.size());
-
-  std::for_each(stack.rbegin(), stack.rbegin() + static_cast<stack_offset_type>(n), [&data](auto &x){ x->soak(data); });
+Environment &Environment::soak(std::string const &data, std::size_t n) noexcept {
+  stack.top(n, [&data](auto &x){ x.soak(data); }, poolFor(n, data.size()));
 
   return *this;
 }
 
 /**
+ * Reseed the given number of Sponges from the top of the stack using the Sponge at the given depth
  *
+ * A single block is squeezed from the seeder in bulk, and then soaked into
+ * every target; in independent mode, each target further soaks its own depth
+ * (in its decimal representation) so that no two targets end up sharing
+ * their state, without having to squeeze a separate block for each of them.
  *
+ * Should the seeder be among the targets, it is reseeded as well, after
+ * the block has been squeezed from it.
+ *
+ * @param m  Depth of the Sponge to use as seeder (0 being the topmost one)
+ * @param n  Number of Sponges to reseed
+ * @param independent  Whether to derive distinct material for each Sponge reseeded
+ * @return the resulting Environment
  */
 Environment &Environment::reseed(std::size_t m, std::size_t n, bool independent) noexcept {
-  // ???
-  m = std::min(m, stack.size());
+  if (stack.size() <= m) {
+    return *this;
+  }
+
+  std::string block(reseedBlockSize, '\0');
+  stack.at(m, [&block](auto &s) { s.squeeze(reinterpret_cast<std::uint8_t *>(&block[0]), block.size()); });
 
-  auto &seeder = *(stack.rbegin() + static_cast<stack_offset_type>(m));
+  if (independent) {
+    stack.topIndexed(n, [&block](auto &x, std::size_t depth) { x.soak(block).soak(std::to_string(depth)); }, poolFor(n, block.size()));
+  } else {
+    stack.top(n, [&block](auto &x) { x.soak(block); }, poolFor(n, block.size()));
+  }
 
+  return *this;
 }
 
 /**
@@ -297,10 +503,8 @@ Environment &Environment::reseed(std::size_t m, std::size_t n, bool independent)
  * @return the resulting Environment
  */
 Environment &Environment::step(std::size_t n, std::size_t m) noexcept {
-  n = std::min(n, stack.size());
-
   if (0 != m) {
-    std::for_each(stack.rbegin(), stack.rbegin() + static_cast<stack_offset_type>(n), [m](auto &x){ x->step(m); });
+    stack.top(n, [m](auto &x){ x.step(m); }, poolFor(n, m));
   }
 
   return *this;
@@ -315,10 +519,8 @@ Environment &Environment::step(std::size_t n, std::size_t m) noexcept {
  * @param what  What to write to the output stream
  * @return the resulting Environment
  */
-Environment &Environment::echo(std::string &what) noexcept {
-  std::ostringstream ss;
-  ss << what;
-  sout << ss.str();
+Environment &Environment::echo(std::string const &what) noexcept {
+  writer->text(what).flush();
 
   return *this;
 }
@@ -330,14 +532,96 @@ Environment &Environment::echo(std::string &what) noexcept {
  * @return the resulting Environment
  */
 Environment &Environment::exit(bool silent) noexcept {
+  writer->sync();
   if (!silent) {
-    for (auto &s : stack) {
-      serr << s->dump() << std::endl;
-    }
+    stack.each([this](auto const &s) { serr << s.dump() << std::endl; });
   }
 
   return *this;
 }
 
+
+/**
+ * Determine the thread pool to run a multi-Sponge command on, given its estimated work
+ *
+ * Every Sponge is counted as at least one transformation step, so as to
+ * account for the per-Sponge overhead even in commands doing next to no
+ * work on each (eg. reset); soaking is counted as one step per byte soaked,
+ * as default Sponges apply 8 rounds per 8-byte block.
+ *
+ * @param n  Number of Sponges involved
+ * @param work  Estimated work per Sponge (in transformation steps)
+ * @return the thread pool to use, or nullptr to run the command on the calling thread
+ */
+ThreadPool *Environment::poolFor(std::size_t n, std::size_t work) const noexcept {
+  n = std::min(n, stack.size());
+  if (work < parallelWorkThreshold && n * (work + 1) < parallelWorkThreshold) {
+    return nullptr;
+  }
+  return pool.get();
+}
+
+/**
+ * Write the given list of naturals, separated by spaces and followed by a newline
+ *
+ * @param values  Values to write
+ */
+void Environment::writeList(std::vector<std::size_t> const &values) noexcept {
+  if (Format::Text != outputFormat) {
+    std::size_t i = 0;
+    writeValues(values.size(), [&values, &i]() { return values[i++]; });
+    return;
+  }
+
+  for (std::size_t i = 0; i < values.size(); i++) {
+    writer->natural(values[i], i + 1 < values.size() ? ' ' : '\n');
+  }
+  if (values.empty()) {
+    writer->text("\n");
+  }
+}
+
+
+/**
+ * Write the given number of values, as produced by the given generator, in the current output format
+ *
+ * Binary values are generated in place into the writer's storage.
+ *
+ * @param count  Number of values to write
+ * @param generate  Generator to call for each value (returning either a std::uint64_t or a long double)
+ */
+template <typename G>
+void Environment::writeValues(std::size_t count, G const &generate) noexcept {
+  switch (outputFormat) {
+    case Format::Uint32:
+      writeBinary<std::uint32_t>(*writer, count, generate);
+      break;
+    case Format::Uint64:
+      writeBinary<std::uint64_t>(*writer, count, generate);
+      break;
+    case Format::Float64:
+      writeBinary<double>(*writer, count, generate);
+      break;
+    case Format::Text:
+    default:
+      for (std::size_t i = 0; i < count; i++) {
+        writeText(*writer, generate());
+      }
+      break;
+  }
+}
+
+/**
+ * Write a NumPy .npy header for an array of the given shape, if so requested and using a binary output format
+ *
+ * @param rows  Number of rows
+ * @param columns  Number of columns (0 for a one-dimensional array)
+ */
+void Environment::writeHeader(std::size_t rows, std::size_t columns) noexcept {
+  if (outputNpy && Format::Text != outputFormat) {
+    writer->text(npyHeader(Format::Uint32 == outputFormat ? "<u4" : Format::Uint64 == outputFormat ? "<u8" : "<f8", rows, columns));
+  }
+}
+
 }
 
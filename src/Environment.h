@@ -6,10 +6,10 @@
 #include <string>
 #include <iostream>
 #include <memory>
-#include <iterator>
 
-#include "Sponge.h"
-#include "vendor/value_ptr/value_ptr.h"
+#include "BulkWriter.h"
+#include "SpongeStack.h"
+#include "ThreadPool.h"
 
 
 namespace Draupnir {
@@ -20,13 +20,27 @@ namespace Draupnir {
    */
   class Environment {
     public:
+      /**
+       * Output formats for numeric commands
+       *
+       */
+      enum class Format : std::uint8_t {
+        Text, Uint32, Uint64, Float64,
+      };
+
       /**
        * Construct a new execution environment
        *
+       * Output is written through a BulkWriter, and multi-Sponge commands are
+       * run on a ThreadPool, both shared among copies of the Environment,
+       * which must thus not be used concurrently.
+       *
        * @param out  Ostream to use for output
        * @param err  Ostream to use for errors
+       * @param threads  Number of threads to use for multi-Sponge commands (0 to use the hardware concurrency)
+       * @throws std::system_error in case the output formatting thread or the worker threads cannot be started
        */
-      Environment(std::ostream &out = std::cout, std::ostream &err = std::cerr) noexcept;
+      Environment(std::ostream &out = std::cout, std::ostream &err = std::cerr, std::size_t threads = 0);
 
       /**
        * Copy constructor - defaulted
@@ -92,6 +106,15 @@ namespace Draupnir {
       Environment &sink(std::size_t n = 1, std::size_t m = 1) noexcept;
 
 
+      /**
+       * Set the output format to use for numeric commands
+       *
+       * @param format  Format to use (either decimal text, or little-endian binary values of the given type)
+       * @param npy  Whether to precede each command's binary output with a NumPy .npy header
+       * @return the resulting Environment
+       */
+      Environment &output(Format format = Format::Text, bool npy = false) noexcept;
+
       /**
        * Generate the given number of raw bytes from the topmost Sponge
        *
@@ -102,44 +125,49 @@ namespace Draupnir {
       Environment &raw(std::size_t count = 10, bool hex = false) noexcept;
 
       /**
-       * Generate a natural number from 0 to the number given
+       * Generate the given number of natural numbers from 0 to the number given
        *
        * @param high  Maximum number to generate
+       * @param count  Number of naturals to generate
        * @return the resulting Environment
        */
-      Environment &natural(std::size_t high = 9) noexcept;
+      Environment &natural(std::size_t high = 9, std::size_t count = 1) noexcept;
 
       /**
-       * Generate a real number from 0.0 o the number given
+       * Generate the given number of real numbers from 0.0 to the number given
        *
        * @param high  Maximum number to generate
+       * @param count  Number of reals to generate
        * @return the resulting Environment
        */
-      Environment &real(long double high = 1.0l) noexcept;
+      Environment &real(long double high = 1.0l, std::size_t count = 1) noexcept;
 
       /**
-       * Generate a permutation of the numbers between 0 and the given number
+       * Generate the given number of permutations of the numbers between 0 and the given number
        *
        * @param highElem  Highest element to permute
+       * @param count  Number of permutations to generate
        * @return the resulting Environment
        */
-      Environment &permutation(std::size_t highElem = 9) noexcept;
+      Environment &permutation(std::size_t highElem = 9, std::size_t count = 1) noexcept;
 
       /**
-       * Generate a cycle of the numbers between 0 and the given number
+       * Generate the given number of cycles of the numbers between 0 and the given number
        *
        * @param highElem  Highest element to permute
+       * @param count  Number of cycles to generate
        * @return the resulting Environment
        */
-      Environment &cycle(std::size_t highElem = 9) noexcept;
+      Environment &cycle(std::size_t highElem = 9, std::size_t count = 1) noexcept;
 
       /**
-       * Generate a derangement of the numbers between 0 and the given number
+       * Generate the given number of derangements of the numbers between 0 and the given number
        *
        * @param highElem  Highest element to permute
+       * @param count  Number of derangements to generate
        * @return the resulting Environment
        */
-      Environment &derangement(std::size_t highElem = 9) noexcept;
+      Environment &derangement(std::size_t highElem = 9, std::size_t count = 1) noexcept;
 
       /**
        * Generate a sample of the given size, for the elements between 0 and the number given, using the given parts, either with or without replacements
@@ -150,7 +178,7 @@ namespace Draupnir {
        * @param replacements  Whether to allow replacements or not
        * @return the resulting Environment
        */
-      Environment &sample(std::size_t count = 1, std::size_t highElem = 9, std::vector<std::size_t> parts = {}, bool replacements = true) noexcept;
+      Environment &sample(std::size_t count = 1, std::size_t highElem = 9, std::vector<std::size_t> const &parts = {}, bool replacements = true) noexcept;
 
 
       // Environment &create(std::size_t width = 64, unsigned long long generator = 0ull, unsigned long long start = ~0ull, unsigned long long mask = ~0ull, )
@@ -161,7 +189,7 @@ namespace Draupnir {
        * @param state  State to unserialize
        * @return the resulting Environment
        */
-      Environment &load(std::string &state);
+      Environment &load(std::string const &state);
 
       /**
        * Unserialize the given number of lines in the given file
@@ -170,7 +198,7 @@ namespace Draupnir {
        * @param count  Number of lines to deserialize (all if 0)
        * @return the resulting Environment
        */
-      Environment &open(std::string &file, std::size_t count = 0);
+      Environment &open(std::string const &file, std::size_t count = 0);
 
       /**
        * Reset the given number of Sponges from the top of the stack to their starting states
@@ -187,11 +215,15 @@ namespace Draupnir {
        * @param n  Number of Sponges to soak
        * @return the resulting Environment
        */
-      Environment &soak(std::string &data, std::size_t n = 1) noexcept;
+      Environment &soak(std::string const &data, std::size_t n = 1) noexcept;
 
       /**
+       * Reseed the given number of Sponges from the top of the stack using the Sponge at the given depth
        *
-       *
+       * @param m  Depth of the Sponge to use as seeder (0 being the topmost one)
+       * @param n  Number of Sponges to reseed
+       * @param independent  Whether to derive distinct material for each Sponge reseeded
+       * @return the resulting Environment
        */
       Environment &reseed(std::size_t m = 1, std::size_t n = 1, bool independent = false) noexcept;
 
@@ -211,7 +243,7 @@ namespace Draupnir {
        * @param what  What to write to the output stream
        * @return the resulting Environment
        */
-      Environment &echo(std::string &what) noexcept;
+      Environment &echo(std::string const &what) noexcept;
 
       /**
        * Flushes the stack and dumps its representation to serr
@@ -223,16 +255,45 @@ namespace Draupnir {
 
     protected:
       /**
-       * Sponge stack
+       * Determine the thread pool to run a multi-Sponge command on, given its estimated work
+       *
+       * @param n  Number of Sponges involved
+       * @param work  Estimated work per Sponge (in transformation steps)
+       * @return the thread pool to use, or nullptr to run the command on the calling thread
+       */
+      ThreadPool *poolFor(std::size_t n, std::size_t work) const noexcept __attribute__((pure));
+
+      /**
+       * Write the given list of naturals, separated by spaces and followed by a newline
+       *
+       * @param values  Values to write
+       */
+      void writeList(std::vector<std::size_t> const &values) noexcept;
+
+      /**
+       * Write the given number of values, as produced by the given generator, in the current output format
+       *
+       * Binary values are generated in place into the writer's storage.
        *
+       * @param count  Number of values to write
+       * @param generate  Generator to call for each value (returning either a std::uint64_t or a long double)
        */
-      std::vector<value_ptr<Sponge>> stack;
+      template <typename G>
+      void writeValues(std::size_t count, G const &generate) noexcept;
 
       /**
-       * Using declaration for stack iterator offsets
+       * Write a NumPy .npy header for an array of the given shape, if so requested and using a binary output format
        *
+       * @param rows  Number of rows
+       * @param columns  Number of columns (0 for a one-dimensional array)
        */
-      using stack_offset_type = typename std::iterator_traits<std::vector<value_ptr<Sponge>>::iterator>::difference_type;
+      void writeHeader(std::size_t rows, std::size_t columns = 0) noexcept;
+
+      /**
+       * Sponge stack
+       *
+       */
+      SpongeStack stack;
 
       /**
        * Output stream
@@ -245,6 +306,30 @@ namespace Draupnir {
        *
        */
       std::ostream &serr;
+
+      /**
+       * Thread pool for multi-Sponge commands (shared among copies)
+       *
+       */
+      std::shared_ptr<ThreadPool> pool;
+
+      /**
+       * Output writer (formatting in its own thread)
+       *
+       */
+      std::shared_ptr<BulkWriter> writer;
+
+      /**
+       * Output format for numeric commands
+       *
+       */
+      Format outputFormat;
+
+      /**
+       * Whether to precede each command's binary output with a NumPy .npy header
+       *
+       */
+      bool outputNpy;
   };
 
 }
@@ -0,0 +1,473 @@
+#include "ExternalShuffle.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "LineReader.h"
+#include "Random.h"
+#include "ThreadPool.h"
+
+
+namespace {
+
+/**
+ * Bucket size to aim for when deriving the number of buckets from the input's size
+ *
+ */
+constexpr std::size_t externalShuffleBucketSize = std::size_t(1) << 25;
+
+/**
+ * Largest bucket to shuffle in memory (larger ones are split into further buckets)
+ *
+ */
+constexpr std::size_t externalShuffleBucketLimit = std::size_t(1) << 26;
+
+/**
+ * Memory to devote to the buckets being shuffled at any given time (bounding how many are held at once)
+ *
+ */
+constexpr std::size_t externalShuffleMemoryBudget = std::size_t(1) << 31;
+
+/**
+ * Deepest level of bucket splitting (past which buckets are shuffled in memory whatever their size)
+ *
+ */
+constexpr std::size_t externalShuffleMaxDepth = 4;
+
+/**
+ * Largest number of buckets to derive from the input's size
+ *
+ */
+constexpr std::size_t externalShuffleMaxBuckets = 512;
+
+/**
+ * Number of buckets to use when the input's size is not known in advance
+ *
+ */
+constexpr std::size_t externalShuffleDefaultBuckets = 256;
+
+/**
+ * Size of each bucket's write buffer
+ *
+ */
+constexpr std::size_t externalShuffleBufferSize = std::size_t(1) << 18;
+
+/**
+ * Write the given data to the given file descriptor in its entirety
+ *
+ * @param fd  File descriptor to write to
+ * @param data  Pointer to the data to write
+ * @param size  Number of bytes to write
+ * @param path  Path to report on failure
+ * @throws std::system_error in case writing fails
+ */
+void writeAll(int fd, char const *data, std::size_t size, std::string const &path) {
+  while (0 < size) {
+    ssize_t written = ::write(fd, data, size);
+    if (written < 0) {
+      if (EINTR == errno) {
+        continue;
+      }
+      throw std::system_error(errno, std::system_category(), "Cannot write '" + path + "'");
+    }
+    data += written;
+    size -= static_cast<std::size_t>(written);
+  }
+}
+
+/**
+ * Temporary bucket file, written to through a buffer
+ *
+ * The underlying file is unlinked right after being created, so that it
+ * vanishes once closed.
+ *
+ */
+class Bucket {
+  public:
+    /**
+     * Create a new bucket in the given directory
+     *
+     * @param directory  Directory where to create the temporary file
+     * @throws std::system_error in case the file cannot be created
+     */
+    explicit Bucket(std::string const &directory) : _path{directory + "/draupnir-XXXXXX"}, _size{0}, _buffer{}, _fd{-1} {
+      std::vector<char> name(_path.begin(), _path.end());
+      name.push_back('\0');
+      _fd = ::mkstemp(name.data());
+      if (_fd < 0) {
+        throw std::system_error(errno, std::system_category(), "Cannot create '" + _path + "'");
+      }
+      _path = name.data();
+      ::unlink(name.data());
+      _buffer.reserve(externalShuffleBufferSize);
+    }
+
+    /**
+     * Copy constructor - deleted
+     *
+     * @param other  Bucket to copy from
+     */
+    Bucket(Bucket const &other) = delete;
+
+    /**
+     * Assignment operator - deleted
+     *
+     * @param other  Bucket to assign
+     * @return the newly assigned Bucket
+     */
+    Bucket &operator=(Bucket const &other) = delete;
+
+    /**
+     * Destructor - close the underlying file
+     *
+     */
+    ~Bucket() noexcept {
+      ::close(_fd);
+    }
+
+    /**
+     * Append the given line (and a terminator) to the bucket
+     *
+     * @param line  Pointer to the line's first character
+     * @param length  Line length (excluding the line terminator)
+     * @throws std::system_error in case writing fails
+     */
+    void append(char const *line, std::size_t length) {
+      if (externalShuffleBufferSize < _buffer.size() + length + 1) {
+        flush();
+      }
+      if (externalShuffleBufferSize < length + 1) {
+        writeAll(_fd, line, length, _path);
+        writeAll(_fd, "\n", 1, _path);
+      } else {
+        _buffer.insert(_buffer.end(), line, line + length);
+        _buffer.push_back('\n');
+      }
+      _size += length + 1;
+    }
+
+    /**
+     * Retrieve the number of bytes appended so far
+     *
+     * @return the bucket's size
+     */
+    std::size_t size() const noexcept {
+      return _size;
+    }
+
+    /**
+     * Write out the buffered lines
+     *
+     * @throws std::system_error in case writing fails
+     */
+    void flush() {
+      writeAll(_fd, _buffer.data(), _buffer.size(), _path);
+      _buffer.clear();
+    }
+
+    /**
+     * Read back the bucket's contents in their entirety
+     *
+     * The buffered lines must have been flushed beforehand.
+     *
+     * @return a vector holding the bucket's contents
+     * @throws std::system_error in case reading fails
+     */
+    std::vector<char> contents() const {
+      std::vector<char> result(_size);
+      std::size_t done = 0;
+      while (done < _size) {
+        ssize_t got = ::pread(_fd, result.data() + done, _size - done, static_cast<off_t>(done));
+        if (got <= 0) {
+          if (got < 0 && EINTR == errno) {
+            continue;
+          }
+          throw std::system_error(0 == got ? EIO : errno, std::system_category(), "Cannot read '" + _path + "'");
+        }
+        done += static_cast<std::size_t>(got);
+      }
+      return result;
+    }
+
+    /**
+     * Call the given function on every line in the bucket, in order
+     *
+     * The bucket is mapped rather than read, so that scanning it takes no
+     * more memory than the page cache is willing to give. The buffered lines
+     * must have been flushed beforehand.
+     *
+     * @param fn  Function to call on each line's first character and length (excluding the line terminator)
+     * @throws std::system_error in case the bucket cannot be mapped
+     */
+    template <typename F>
+    void forEachLine(F const &fn) const {
+      if (0 == _size) {
+        return;
+      }
+      void *map = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, _fd, 0);
+      if (MAP_FAILED == map) {
+        throw std::system_error(errno, std::system_category(), "Cannot map '" + _path + "'");
+      }
+      ::madvise(map, _size, MADV_SEQUENTIAL);
+
+      char const *data = static_cast<char const *>(map);
+      try {
+        for (char const *p = data, *end = data + _size; p < end; ) {
+          char const *eol = static_cast<char const *>(std::memchr(p, '\n', static_cast<std::size_t>(end - p)));
+          fn(p, static_cast<std::size_t>(eol - p));
+          p = eol + 1;
+        }
+      } catch (...) {
+        ::munmap(map, _size);
+        throw;
+      }
+      ::munmap(map, _size);
+    }
+
+  protected:
+    /**
+     * Path the underlying file was created with (for error reporting only)
+     *
+     */
+    std::string _path;
+
+    /**
+     * Number of bytes appended so far
+     *
+     */
+    std::size_t _size;
+
+    /**
+     * Write buffer
+     *
+     */
+    std::vector<char> _buffer;
+
+    /**
+     * Underlying file descriptor
+     *
+     */
+    int _fd;
+};
+
+/**
+ * Lines in a bucket's contents, as pointers to their first character and lengths (including the line terminator)
+ *
+ */
+using Lines = std::vector<std::pair<char const *, std::size_t>>;
+
+/**
+ * Create the given number of empty buckets in the given directory
+ *
+ * @param count  Number of buckets to create
+ * @param directory  Directory where to create the temporary files
+ * @return the buckets created
+ * @throws std::system_error in case any file cannot be created
+ */
+std::vector<std::unique_ptr<Bucket>> makeBuckets(std::size_t count, std::string const &directory) {
+  std::vector<std::unique_ptr<Bucket>> result;
+  for (std::size_t b = 0; b < count; b++) {
+    result.emplace_back(new Bucket(directory));
+  }
+  return result;
+}
+
+/**
+ * Determine the number of buckets to scatter the given number of bytes into
+ *
+ * @param size  Number of bytes to scatter
+ * @return the number of buckets to use
+ */
+std::size_t bucketsFor(std::size_t size) noexcept {
+  return std::min(externalShuffleMaxBuckets, size / externalShuffleBucketSize + 1);
+}
+
+/**
+ * Shuffle the lines in the given bucket contents
+ *
+ * @param s  Sponge to use for randomization
+ * @param data  Bucket contents (every line terminated by '\n')
+ * @param lines  Vector to fill with the shuffled lines
+ */
+void shuffleBucket(Draupnir::Sponge &s, std::vector<char> const &data, Lines &lines) {
+  lines.clear();
+  for (char const *p = data.data(), *end = data.data() + data.size(); p < end; ) {
+    char const *eol = static_cast<char const *>(std::memchr(p, '\n', static_cast<std::size_t>(end - p)));
+    lines.emplace_back(p, static_cast<std::size_t>(eol - p) + 1);
+    p = eol + 1;
+  }
+
+  Draupnir::Random::shuffle(s, lines.begin(), lines.end());
+}
+
+/**
+ * Write the given lines to the given file descriptor, gathering them through a bounded buffer
+ *
+ * @param fd  File descriptor to write to
+ * @param lines  Lines to write
+ * @param path  Path to report on failure
+ * @throws std::system_error in case writing fails
+ */
+void writeLines(int fd, Lines const &lines, std::string const &path) {
+  std::vector<char> buffer;
+  buffer.reserve(externalShuffleBufferSize);
+  for (auto const &line : lines) {
+    if (externalShuffleBufferSize < buffer.size() + line.second) {
+      writeAll(fd, buffer.data(), buffer.size(), path);
+      buffer.clear();
+    }
+    if (externalShuffleBufferSize < line.second) {
+      writeAll(fd, line.first, line.second, path);
+    } else {
+      buffer.insert(buffer.end(), line.first, line.first + line.second);
+    }
+  }
+  writeAll(fd, buffer.data(), buffer.size(), path);
+}
+
+/**
+ * Shuffle the given buckets' lines, writing them out in bucket order
+ *
+ * Bucket b draws from the substream indexed b, derived from a clone of the
+ * given sponge; the sponge is stepped once afterwards.
+ *
+ * Buckets no larger than externalShuffleBucketLimit are shuffled in memory,
+ * in rounds of consecutive buckets run on the given pool, as many at a time
+ * as both the pool and externalShuffleMemoryBudget allow; larger ones are
+ * scattered into further buckets using their substream, and these shuffled
+ * in turn, so that the memory held is bounded whatever the input's size.
+ * Since the limit does not depend on the pool, neither does the result.
+ *
+ * @param s  Sponge to use for randomization
+ * @param buckets  Buckets to shuffle (released as they are consumed)
+ * @param fd  File descriptor to write to
+ * @param output  Path to report on failure
+ * @param directory  Directory where to create the temporary files
+ * @param pool  Thread pool to run on
+ * @param depth  Current splitting depth
+ * @throws std::system_error in case any file cannot be created, mapped, read, or written
+ */
+void shuffleBuckets(Draupnir::Sponge &s, std::vector<std::unique_ptr<Bucket>> &buckets, int fd, std::string const &output, std::string const &directory, Draupnir::ThreadPool &pool, std::size_t depth) {
+  std::unique_ptr<Draupnir::Sponge> base(s.clone());
+  s.step();
+
+  auto inMemory = [&buckets, depth](std::size_t b) {
+    return buckets[b]->size() <= externalShuffleBucketLimit || externalShuffleMaxDepth <= depth;
+  };
+
+  std::size_t width = std::max(std::size_t(1), std::min(pool.size(), externalShuffleMemoryBudget / externalShuffleBucketLimit));
+  std::vector<std::vector<char>> data(width);
+  std::vector<Lines> lines(width);
+  for (std::size_t b = 0; b < buckets.size(); ) {
+    if (!inMemory(b)) {
+      auto sub = Draupnir::Random::substream(*base, b);
+      std::vector<std::unique_ptr<Bucket>> split = makeBuckets(bucketsFor(buckets[b]->size()), directory);
+      buckets[b]->forEachLine([&sub, &split](char const *line, std::size_t length) {
+        split[Draupnir::Random::natural<std::size_t>(*sub, split.size() - 1)]->append(line, length);
+      });
+      buckets[b].reset();
+      for (auto &bucket : split) {
+        bucket->flush();
+      }
+      shuffleBuckets(*sub, split, fd, output, directory, pool, depth + 1);
+      b++;
+      continue;
+    }
+
+    std::size_t count = 1;
+    while (count < width && b + count < buckets.size() && inMemory(b + count)) {
+      count++;
+    }
+    pool.run(count, [&](std::size_t from, std::size_t to) {
+      for (std::size_t i = from; i < to; i++) {
+        auto sub = Draupnir::Random::substream(*base, b + i);
+        data[i] = buckets[b + i]->contents();
+        buckets[b + i].reset();
+        shuffleBucket(*sub, data[i], lines[i]);
+      }
+    });
+    for (std::size_t i = 0; i < count; i++) {
+      writeLines(fd, lines[i], output);
+      Lines().swap(lines[i]);
+      std::vector<char>().swap(data[i]);
+    }
+    b += count;
+  }
+}
+
+}
+
+namespace Draupnir {
+
+namespace Random {
+
+/**
+ * Shuffle the lines in the given file into another one, using external memory
+ *
+ * Buckets are shuffled in rounds of consecutive buckets, each round being
+ * written out in bucket order once complete; oversized buckets are split
+ * further instead.
+ *
+ * @param s  Sponge to use for randomization
+ * @param input  Path to the file to shuffle ("-" for the standard input)
+ * @param output  Path to the file to write ("-" for the standard output)
+ * @param directory  Directory where to create the temporary files
+ * @param buckets  Number of buckets to use (0 to derive it from the input's size, if known)
+ * @param threads  Number of threads to use (0 to use the hardware concurrency)
+ * @throws std::system_error in case any file cannot be opened, created, read, or written
+ */
+void shuffleLines(Draupnir::Sponge &s, std::string const &input, std::string const &output, std::string const &directory, std::size_t buckets, std::size_t threads) {
+  // first pass: scatter the lines into buckets
+  LineReader reader(input);
+  if (0 == buckets) {
+    buckets = reader.mapped() ? bucketsFor(reader.size()) : externalShuffleDefaultBuckets;
+  }
+
+  std::vector<std::unique_ptr<Bucket>> scatter = makeBuckets(buckets, directory);
+
+  char const *line;
+  std::size_t length;
+  while (reader.next(line, length)) {
+    scatter[natural<std::size_t>(s, buckets - 1)]->append(line, length);
+  }
+  for (auto &bucket : scatter) {
+    bucket->flush();
+  }
+
+  // second pass: shuffle each bucket
+  int fd = STDOUT_FILENO;
+  if ("-" != output) {
+    fd = ::open(output.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+      throw std::system_error(errno, std::system_category(), "Cannot open '" + output + "'");
+    }
+  }
+
+  try {
+    Draupnir::ThreadPool pool(threads);
+    shuffleBuckets(s, scatter, fd, output, directory, pool, 0);
+  } catch (...) {
+    if (STDOUT_FILENO != fd) {
+      ::close(fd);
+    }
+    throw;
+  }
+
+  if (STDOUT_FILENO != fd && 0 != ::close(fd)) {
+    throw std::system_error(errno, std::system_category(), "Cannot write '" + output + "'");
+  }
+}
+
+}
+
+}
@@ -0,0 +1,56 @@
+#ifndef DRAUPNIR_EXTERNAL_SHUFFLE_H__
+#define DRAUPNIR_EXTERNAL_SHUFFLE_H__
+
+#include <cstdint>
+#include <string>
+
+#include "Sponge.h"
+
+namespace Draupnir {
+
+  namespace Random {
+
+    /**
+     * Shuffle the lines in the given file into another one, using external memory
+     *
+     * This function performs a two-pass external shuffle: the first pass
+     * scatters every line into a uniformly random bucket, buckets being
+     * temporary files written to in large sequential blocks; the second one
+     * reads each bucket back in its entirety, shuffles its lines in memory,
+     * and writes them to the output, bucket after bucket. Since every
+     * assignment of lines to buckets is equally likely, and every ordering
+     * within a bucket is too, the resulting permutation is uniform.
+     *
+     * Buckets are shuffled by a pool of threads, each drawing from its own
+     * substream, derived from a clone of the given sponge (as left by the
+     * first pass) and indexed by the bucket's position, so that the result is
+     * fully determined by the sponge's state and the input: neither the
+     * number of threads used nor their scheduling affect it. The given sponge
+     * is stepped once afterwards.
+     *
+     * Only buckets up to a fixed size are shuffled in memory, and only as
+     * many at a time as a fixed memory budget allows; larger buckets (eg.
+     * when the input is too large for the number of buckets) are scattered
+     * into further buckets in the same way, using their own substream, so
+     * that the memory used is bounded whatever the input's size.
+     *
+     * Temporary files are created in the given directory and unlinked right
+     * away, so that nothing is left behind even on abnormal termination.
+     *
+     * Every line is written terminated by '\n', even the input's last one.
+     *
+     * @param s  Sponge to use for randomization
+     * @param input  Path to the file to shuffle ("-" for the standard input)
+     * @param output  Path to the file to write ("-" for the standard output)
+     * @param directory  Directory where to create the temporary files
+     * @param buckets  Number of buckets to use (0 to derive it from the input's size, if known)
+     * @param threads  Number of threads to use (0 to use the hardware concurrency)
+     * @throws std::system_error in case any file cannot be opened, created, read, or written
+     */
+    void shuffleLines(Draupnir::Sponge &s, std::string const &input, std::string const &output, std::string const &directory, std::size_t buckets = 0, std::size_t threads = 0);
+
+  }
+
+}
+
+#endif /* DRAUPNIR_EXTERNAL_SHUFFLE_H__ */
@@ -0,0 +1,97 @@
+#ifndef DRAUPNIR_GRAPH_H__
+#define DRAUPNIR_GRAPH_H__
+
+#include <cstdint>
+
+#include "Sponge.h"
+
+namespace Draupnir {
+
+  namespace Random {
+
+    /**
+     * Generate an Erdős--Rényi G(n, p) random graph
+     *
+     * This function generates an undirected graph without self-loops on the
+     * vertices 0 to n - 1, where each of the n (n - 1) / 2 possible edges is
+     * present independently with probability p; rather than flipping a coin
+     * for every pair, the number of absent edges before the next present one
+     * is drawn from the geometric distribution (as per Batagelj and Brandes),
+     * so that the graph is generated in O(n + m) time, m being the number of
+     * edges generated.
+     *
+     * The pairs are split into contiguous chunks (their number depending on n
+     * alone), each drawing from its own substream, derived from a clone of
+     * the given sponge and indexed by the chunk's position, so that the graph
+     * is fully determined by the sponge's state, n, and p: neither the number
+     * of threads used nor their scheduling affect it. The given sponge is
+     * stepped once afterwards.
+     *
+     * Each edge is reported once, by calling edge(u, v) with u < v; edges
+     * within a chunk are reported in ascending order of v (then u), but
+     * chunks are processed concurrently when using more than one thread, so
+     * that the given function must be thread-safe in that case.
+     *
+     * @param s  Sponge to use for randomization
+     * @param n  Number of vertices
+     * @param p  Probability of each edge being present
+     * @param edge  Function to call on each edge's endpoints
+     * @param threads  Number of threads to use (0 to use the hardware concurrency)
+     * @throws std::domain_error in case the number of vertex pairs does not fit in a std::size_t
+     */
+    template <typename F, typename S>
+    void gnpGraph(S &s, std::size_t n, double p, F const &edge, std::size_t threads = 1);
+
+    /**
+     * Generate an Erdős--Rényi G(n, m) random graph
+     *
+     * This function generates an undirected graph without self-loops on the
+     * vertices 0 to n - 1, having exactly m edges (clamped to the number of
+     * vertex pairs) chosen uniformly at random, by sampling the edges' indices
+     * without replacement and mapping each of them to its endpoints.
+     *
+     * Each edge is reported once, by calling edge(u, v) with u < v, in no
+     * particular order.
+     *
+     * @param s  Sponge to use for randomization
+     * @param n  Number of vertices
+     * @param m  Number of edges
+     * @param edge  Function to call on each edge's endpoints
+     * @throws std::domain_error in case the number of vertex pairs does not fit in a std::size_t
+     */
+    template <typename F, typename S>
+    void gnmGraph(S &s, std::size_t n, std::size_t m, F const &edge);
+
+    /**
+     * Generate a random bipartite graph
+     *
+     * This function generates a bipartite graph between the vertices 0 to
+     * n1 - 1 on one side and 0 to n2 - 1 on the other, where each of the
+     * n1 n2 possible edges is present independently with probability p; it
+     * does so by skipping absent edges in geometric jumps, splitting the
+     * pairs into deterministic chunks, just as gnpGraph does.
+     *
+     * Each edge is reported by calling edge(u, v), u being the vertex on the
+     * first side and v the one on the second; edges within a chunk are
+     * reported in ascending order of u (then v), but chunks are processed
+     * concurrently when using more than one thread, so that the given
+     * function must be thread-safe in that case.
+     *
+     * @param s  Sponge to use for randomization
+     * @param n1  Number of vertices on the first side
+     * @param n2  Number of vertices on the second side
+     * @param p  Probability of each edge being present
+     * @param edge  Function to call on each edge's endpoints
+     * @param threads  Number of threads to use (0 to use the hardware concurrency)
+     * @throws std::domain_error in case the number of vertex pairs does not fit in a std::size_t
+     */
+    template <typename F, typename S>
+    void bipartiteGraph(S &s, std::size_t n1, std::size_t n2, double p, F const &edge, std::size_t threads = 1);
+
+  }
+
+}
+
+#include "Graph.hpp"
+
+#endif /* DRAUPNIR_GRAPH_H__ */
@@ -0,0 +1,217 @@
+#ifndef DRAUPNIR_GRAPH_HPP__
+#define DRAUPNIR_GRAPH_HPP__
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+
+#include "Graph.h"
+#include "Random.h"
+#include "ThreadPool.h"
+
+namespace {
+
+  /**
+   * Smallest number of vertex pairs to assign to a chunk
+   *
+   */
+  constexpr std::size_t graphMinChunk = std::size_t(1) << 20;
+
+  /**
+   * Largest number of chunks to split the vertex pairs into
+   *
+   */
+  constexpr std::size_t graphMaxChunks = std::size_t(1) << 12;
+
+  /**
+   * Determine the number of pairs of distinct vertices
+   *
+   * @param n  Number of vertices
+   * @return the number of pairs of distinct vertices
+   * @throws std::domain_error in case the number of pairs does not fit in a std::size_t
+   */
+  inline std::size_t graphPairs(std::size_t n) {
+    unsigned __int128 pairs = static_cast<unsigned __int128>(n) * (0 == n ? 0 : n - 1) / 2;
+    if (std::numeric_limits<std::size_t>::max() < pairs) {
+      throw std::domain_error("Too many vertex pairs");
+    }
+    return static_cast<std::size_t>(pairs);
+  }
+
+  /**
+   * Map the given pair index to its endpoints
+   *
+   * Pairs are indexed in ascending order of their larger endpoint (then their
+   * smaller one), so that the pair (u, v), u < v, has index v (v - 1) / 2 + u.
+   *
+   * @param index  Pair index
+   * @param u  Output smaller endpoint
+   * @param v  Output larger endpoint
+   */
+  inline void graphPair(std::size_t index, std::size_t &u, std::size_t &v) noexcept {
+    auto start = [](std::size_t x) { return static_cast<unsigned __int128>(x) * (0 == x ? 0 : x - 1) / 2; };
+    v = static_cast<std::size_t>((1.0L + std::sqrt(1.0L + 8.0L * static_cast<long double>(index))) / 2.0L);
+    while (index < start(v)) {
+      v--;
+    }
+    while (start(v + 1) <= index) {
+      v++;
+    }
+    u = static_cast<std::size_t>(index - start(v));
+  }
+
+  /**
+   * Walk over the given number of pairs, skipping absent edges in geometric jumps
+   *
+   * The given function is called with the number of absent edges skipped
+   * since the previous present one (or the start) for each present edge.
+   *
+   * @param s  Sponge to use for randomization
+   * @param count  Number of pairs to walk over
+   * @param p  Probability of each edge being present
+   * @param next  Function to call on each present edge
+   */
+  template <typename S, typename F>
+  void graphSkip(S &s, std::size_t count, double p, F const &next) {
+    if (!(0.0 < p)) {
+      return;
+    }
+    while (true) {
+      std::size_t gap = Draupnir::Random::geometric(s, p);
+      if (count <= gap) {
+        return;
+      }
+      next(gap);
+      count -= gap + 1;
+    }
+  }
+
+  /**
+   * Split the given number of pairs into chunks and walk over each, using the given number of threads
+   *
+   * Chunk c draws from the substream indexed c, derived from a clone of the
+   * given sponge; the sponge is stepped once afterwards.
+   *
+   * @param s  Sponge to use for randomization
+   * @param total  Number of pairs to walk over
+   * @param threads  Number of threads to use (0 to use the hardware concurrency)
+   * @param walk  Function to call on each chunk's substream, first pair index, and number of pairs
+   */
+  template <typename S, typename F>
+  void graphChunks(S &s, std::size_t total, std::size_t threads, F const &walk) {
+    std::size_t chunks = std::max(std::size_t(1), std::min(graphMaxChunks, total / graphMinChunk));
+    auto bound = [total, chunks](std::size_t c) {
+      return total / chunks * c + std::min(c, total % chunks);
+    };
+
+    std::unique_ptr<S> base(s.clone());
+    s.step();
+
+    Draupnir::ThreadPool pool(threads);
+    pool.run(chunks, [&](std::size_t from, std::size_t to) {
+      for (std::size_t c = from; c < to; c++) {
+        auto sub = Draupnir::Random::substream(*base, c);
+        walk(*sub, bound(c), bound(c + 1) - bound(c));
+      }
+    });
+  }
+
+}
+
+namespace Draupnir {
+
+  namespace Random {
+
+    /**
+     * Generate an Erdős--Rényi G(n, p) random graph
+     *
+     * Within each chunk, the current pair is tracked as its endpoints, the
+     * larger one being advanced as many times as the smaller one wraps
+     * around, so that no pair index needs to be mapped back save for the
+     * chunk's first.
+     *
+     * @param s  Sponge to use for randomization
+     * @param n  Number of vertices
+     * @param p  Probability of each edge being present
+     * @param edge  Function to call on each edge's endpoints
+     * @param threads  Number of threads to use (0 to use the hardware concurrency)
+     * @throws std::domain_error in case the number of vertex pairs does not fit in a std::size_t
+     */
+    template <typename F, typename S>
+    void gnpGraph(S &s, std::size_t n, double p, F const &edge, std::size_t threads) {
+      graphChunks(s, graphPairs(n), threads, [&edge, p](S &sub, std::size_t first, std::size_t count) {
+        std::size_t u, v;
+        graphPair(first, u, v);
+        graphSkip(sub, count, p, [&edge, &u, &v](std::size_t gap) {
+          u += gap;
+          while (v <= u) {
+            u -= v;
+            v++;
+          }
+          edge(u, v);
+          u++;
+        });
+      });
+    }
+
+    /**
+     * Generate an Erdős--Rényi G(n, m) random graph
+     *
+     * @param s  Sponge to use for randomization
+     * @param n  Number of vertices
+     * @param m  Number of edges
+     * @param edge  Function to call on each edge's endpoints
+     * @throws std::domain_error in case the number of vertex pairs does not fit in a std::size_t
+     */
+    template <typename F, typename S>
+    void gnmGraph(S &s, std::size_t n, std::size_t m, F const &edge) {
+      for (std::size_t index : uniformSampleWithoutReplacement(s, graphPairs(n), m)) {
+        std::size_t u, v;
+        graphPair(index, u, v);
+        edge(u, v);
+      }
+    }
+
+    /**
+     * Generate a random bipartite graph
+     *
+     * Pairs are indexed as u n2 + v; within each chunk, the current pair is
+     * tracked as its endpoints.
+     *
+     * @param s  Sponge to use for randomization
+     * @param n1  Number of vertices on the first side
+     * @param n2  Number of vertices on the second side
+     * @param p  Probability of each edge being present
+     * @param edge  Function to call on each edge's endpoints
+     * @param threads  Number of threads to use (0 to use the hardware concurrency)
+     * @throws std::domain_error in case the number of vertex pairs does not fit in a std::size_t
+     */
+    template <typename F, typename S>
+    void bipartiteGraph(S &s, std::size_t n1, std::size_t n2, double p, F const &edge, std::size_t threads) {
+      unsigned __int128 total = static_cast<unsigned __int128>(n1) * n2;
+      if (std::numeric_limits<std::size_t>::max() < total) {
+        throw std::domain_error("Too many vertex pairs");
+      }
+
+      graphChunks(s, static_cast<std::size_t>(total), threads, [&edge, n2, p](S &sub, std::size_t first, std::size_t count) {
+        std::size_t u = 0 == n2 ? 0 : first / n2, v = 0 == n2 ? 0 : first % n2;
+        graphSkip(sub, count, p, [&edge, n2, &u, &v](std::size_t gap) {
+          v += gap;
+          if (n2 <= v) {
+            u += v / n2;
+            v %= n2;
+          }
+          edge(u, v);
+          v++;
+        });
+      });
+    }
+
+  }
+
+}
+
+#endif /* DRAUPNIR_GRAPH_HPP__ */
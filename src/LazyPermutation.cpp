@@ -0,0 +1,167 @@
+#include "LazyPermutation.h"
+
+#include <stdexcept>
+
+#include "Random.h"
+
+
+namespace {
+
+  /**
+   * Mix the given value using the SplitMix64 finalizer
+   *
+   * @param x  Value to mix
+   * @return the mixed value
+   */
+  inline std::uint64_t mix(std::uint64_t x) noexcept {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebull;
+    x ^= x >> 31;
+    return x;
+  }
+
+}
+
+
+namespace Draupnir {
+
+namespace Random {
+
+constexpr std::size_t LazyPermutation::rounds;
+
+/**
+ * Construct a permutation of the given size, keyed from the given sponge
+ *
+ * @param s  Sponge to draw the round keys from
+ * @param size  Permutation size
+ */
+LazyPermutation::LazyPermutation(Draupnir::Sponge &s, std::uint64_t size) : _size{size}, _half{1}, _mask{0}, _keys{} {
+  while (_half < 32 && (std::uint64_t(1) << (2 * _half)) < _size) {
+    _half++;
+  }
+  _mask = (std::uint64_t(1) << _half) - 1;
+
+  for (auto &key : _keys) {
+    key = natural<std::uint64_t>(s);
+  }
+}
+
+
+/**
+ * Retrieve the permutation's size
+ *
+ * @return the permutation's size
+ */
+std::uint64_t LazyPermutation::size() const noexcept {
+  return _size;
+}
+
+/**
+ * Evaluate the permutation at the given point
+ *
+ * @param i  Point to evaluate the permutation at
+ * @return the permutation's value at i
+ * @throws std::domain_error in case i is not less than size
+ */
+std::uint64_t LazyPermutation::operator()(std::uint64_t i) const {
+  if (_size <= i) {
+    throw std::domain_error("Point out of range");
+  }
+  do {
+    i = encrypt(i);
+  } while (_size <= i);
+  return i;
+}
+
+/**
+ * Evaluate the inverse permutation at the given point
+ *
+ * @param i  Point to evaluate the inverse permutation at
+ * @return the inverse permutation's value at i
+ * @throws std::domain_error in case i is not less than size
+ */
+std::uint64_t LazyPermutation::inverse(std::uint64_t i) const {
+  if (_size <= i) {
+    throw std::domain_error("Point out of range");
+  }
+  do {
+    i = decrypt(i);
+  } while (_size <= i);
+  return i;
+}
+
+/**
+ * Evaluate the permutation at every given point
+ *
+ * The input and output arrays may coincide.
+ *
+ * @param in  Points to evaluate the permutation at
+ * @param out  Output array for the permutation's values
+ * @param count  Number of points to evaluate
+ * @throws std::domain_error in case any point is not less than size
+ */
+void LazyPermutation::evaluate(std::uint64_t const *in, std::uint64_t *out, std::size_t count) const {
+  for (std::size_t k = 0; k < count; k++) {
+    out[k] = (*this)(in[k]);
+  }
+}
+
+/**
+ * Evaluate the inverse permutation at every given point
+ *
+ * The input and output arrays may coincide.
+ *
+ * @param in  Points to evaluate the inverse permutation at
+ * @param out  Output array for the inverse permutation's values
+ * @param count  Number of points to evaluate
+ * @throws std::domain_error in case any point is not less than size
+ */
+void LazyPermutation::invert(std::uint64_t const *in, std::uint64_t *out, std::size_t count) const {
+  for (std::size_t k = 0; k < count; k++) {
+    out[k] = inverse(in[k]);
+  }
+}
+
+
+/**
+ * Apply the Feistel network once
+ *
+ * Each round maps (L, R) to (R, L ^ F(R)), F being the keyed round function.
+ *
+ * @param x  Value to encrypt (must be less than 2^(2h))
+ * @return the encrypted value
+ */
+std::uint64_t LazyPermutation::encrypt(std::uint64_t x) const noexcept {
+  std::uint64_t l = x >> _half, r = x & _mask;
+  for (std::size_t k = 0; k < rounds; k++) {
+    std::uint64_t t = l ^ (mix(r ^ _keys[k]) & _mask);
+    l = r;
+    r = t;
+  }
+  return (l << _half) | r;
+}
+
+/**
+ * Apply the inverse Feistel network once
+ *
+ * Each round maps (L, R) to (R ^ F(L), L), undoing the rounds in reverse
+ * order.
+ *
+ * @param x  Value to decrypt (must be less than 2^(2h))
+ * @return the decrypted value
+ */
+std::uint64_t LazyPermutation::decrypt(std::uint64_t x) const noexcept {
+  std::uint64_t l = x >> _half, r = x & _mask;
+  for (std::size_t k = rounds; 0 < k; k--) {
+    std::uint64_t t = r ^ (mix(l ^ _keys[k - 1]) & _mask);
+    r = l;
+    l = t;
+  }
+  return (l << _half) | r;
+}
+
+}
+
+}
@@ -0,0 +1,180 @@
+#ifndef DRAUPNIR_LAZY_PERMUTATION_H__
+#define DRAUPNIR_LAZY_PERMUTATION_H__
+
+#include <array>
+#include <cstdint>
+
+#include "Sponge.h"
+
+namespace Draupnir {
+
+  namespace Random {
+
+    /**
+     * Random-access permutation of the numbers between 0 and size - 1, evaluated on demand
+     *
+     * This class never materializes the permutation: instead, it keys a
+     * balanced Feistel network over the smallest even bit width 2h such that
+     * 2^(2h) >= size from a sponge's output, and uses cycle-walking (ie.
+     * re-applying the network until the result falls below size) to restrict
+     * it to arbitrary sizes; since 2^(2h) < 4 * size, fewer than 4 network
+     * evaluations are needed on average.
+     *
+     * Both the permutation and its inverse are thus evaluated in O(1)
+     * expected time and O(1) memory, and evaluations are independent of each
+     * other (so that they may be freely spread across threads).
+     *
+     * The round function is a 64 bit finalizer mix of the half-block xored
+     * with the round key; note that this yields a pseudo-random permutation
+     * suitable for simulation and sampling, not a cryptographically secure
+     * cipher.
+     *
+     */
+    class LazyPermutation {
+      public:
+        /**
+         * Number of Feistel rounds applied
+         *
+         */
+        static constexpr std::size_t rounds = 8;
+
+        /**
+         * Construct a permutation of the given size, keyed from the given sponge
+         *
+         * @param s  Sponge to draw the round keys from
+         * @param size  Permutation size
+         */
+        LazyPermutation(Draupnir::Sponge &s, std::uint64_t size);
+
+        /**
+         * Copy constructor - defaulted
+         *
+         * @param other  LazyPermutation to copy from
+         */
+        LazyPermutation(LazyPermutation const &other) noexcept = default;
+
+        /**
+         * Move constructor - defaulted
+         *
+         * @param other  LazyPermutation to move from
+         */
+        LazyPermutation(LazyPermutation &&other) noexcept = default;
+
+        /**
+         * Assignment operator - defaulted
+         *
+         * @param other  LazyPermutation to assign
+         * @return the newly assigned LazyPermutation
+         */
+        LazyPermutation &operator=(LazyPermutation const &other) noexcept = default;
+
+        /**
+         * Move-assignment operator - defaulted
+         *
+         * @param other  LazyPermutation to move-assign
+         * @return the newly move-assigned LazyPermutation
+         */
+        LazyPermutation &operator=(LazyPermutation &&other) noexcept = default;
+
+        /**
+         * Destructor - defaulted
+         *
+         */
+        ~LazyPermutation() noexcept = default;
+
+        /**
+         * Retrieve the permutation's size
+         *
+         * @return the permutation's size
+         */
+        std::uint64_t size() const noexcept __attribute__((pure));
+
+        /**
+         * Evaluate the permutation at the given point
+         *
+         * @param i  Point to evaluate the permutation at
+         * @return the permutation's value at i
+         * @throws std::domain_error in case i is not less than size
+         */
+        std::uint64_t operator()(std::uint64_t i) const;
+
+        /**
+         * Evaluate the inverse permutation at the given point
+         *
+         * @param i  Point to evaluate the inverse permutation at
+         * @return the inverse permutation's value at i
+         * @throws std::domain_error in case i is not less than size
+         */
+        std::uint64_t inverse(std::uint64_t i) const;
+
+        /**
+         * Evaluate the permutation at every given point
+         *
+         * The input and output arrays may coincide.
+         *
+         * @param in  Points to evaluate the permutation at
+         * @param out  Output array for the permutation's values
+         * @param count  Number of points to evaluate
+         * @throws std::domain_error in case any point is not less than size
+         */
+        void evaluate(std::uint64_t const *in, std::uint64_t *out, std::size_t count) const;
+
+        /**
+         * Evaluate the inverse permutation at every given point
+         *
+         * The input and output arrays may coincide.
+         *
+         * @param in  Points to evaluate the inverse permutation at
+         * @param out  Output array for the inverse permutation's values
+         * @param count  Number of points to evaluate
+         * @throws std::domain_error in case any point is not less than size
+         */
+        void invert(std::uint64_t const *in, std::uint64_t *out, std::size_t count) const;
+
+      protected:
+        /**
+         * Apply the Feistel network once
+         *
+         * @param x  Value to encrypt (must be less than 2^(2h))
+         * @return the encrypted value
+         */
+        std::uint64_t encrypt(std::uint64_t x) const noexcept __attribute__((pure));
+
+        /**
+         * Apply the inverse Feistel network once
+         *
+         * @param x  Value to decrypt (must be less than 2^(2h))
+         * @return the decrypted value
+         */
+        std::uint64_t decrypt(std::uint64_t x) const noexcept __attribute__((pure));
+
+        /**
+         * Permutation size
+         *
+         */
+        std::uint64_t _size;
+
+        /**
+         * Half-block width in bits (ie. h)
+         *
+         */
+        std::uint64_t _half;
+
+        /**
+         * Mask selecting a half-block
+         *
+         */
+        std::uint64_t _mask;
+
+        /**
+         * Round keys
+         *
+         */
+        std::array<std::uint64_t, rounds> _keys;
+    };
+
+  }
+
+}
+
+#endif /* DRAUPNIR_LAZY_PERMUTATION_H__ */
@@ -0,0 +1,208 @@
+#include "LineReader.h"
+
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace Draupnir {
+
+/**
+ * Open the given file for reading
+ *
+ * @param path  Path to the file to read ("-" for the standard input)
+ * @throws std::system_error in case the file cannot be opened or mapped
+ */
+LineReader::LineReader(std::string const &path) : _map{nullptr}, _mapSize{0}, _buffer{}, _begin{nullptr}, _end{nullptr}, _fd{STDIN_FILENO}, _owned{false}, _eof{false}, _partial{false} {
+  if ("-" != path) {
+    _fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (_fd < 0) {
+      throw std::system_error(errno, std::system_category(), "Cannot open '" + path + "'");
+    }
+    _owned = true;
+  }
+
+  // map regular files in their entirety
+  struct stat info;
+  if (0 == ::fstat(_fd, &info) && S_ISREG(info.st_mode)) {
+    _eof = true;
+    if (0 < info.st_size) {
+      _mapSize = static_cast<std::size_t>(info.st_size);
+      void *map = ::mmap(nullptr, _mapSize, PROT_READ, MAP_PRIVATE, _fd, 0);
+      if (MAP_FAILED == map) {
+        int error = errno;
+        if (_owned) {
+          ::close(_fd);
+        }
+        throw std::system_error(error, std::system_category(), "Cannot map '" + path + "'");
+      }
+      // advice values are not flags: request sequential access for the whole map, and read-ahead for its start only
+      ::madvise(map, _mapSize, MADV_SEQUENTIAL);
+      ::madvise(map, _mapSize < readAheadSize ? _mapSize : readAheadSize, MADV_WILLNEED);
+      _map = static_cast<char const *>(map);
+      _begin = _map;
+      _end = _map + _mapSize;
+    }
+  }
+}
+
+/**
+ * Destructor - unmap and close the underlying file
+ *
+ */
+LineReader::~LineReader() noexcept {
+  if (nullptr != _map) {
+    ::munmap(const_cast<char *>(_map), _mapSize);
+  }
+  if (_owned) {
+    ::close(_fd);
+  }
+}
+
+
+/**
+ * Retrieve the next line
+ *
+ * @param line  Output pointer to the line's first character
+ * @param length  Output line length (excluding the line terminator)
+ * @return true if a line was retrieved, false on end of input
+ * @throws std::system_error in case reading fails
+ */
+bool LineReader::next(char const *&line, std::size_t &length) {
+  while (true) {
+    if (_begin < _end) {
+      char const *nl = static_cast<char const *>(std::memchr(_begin, '\n', static_cast<std::size_t>(_end - _begin)));
+      if (nullptr != nl) {
+        line = _begin;
+        length = static_cast<std::size_t>(nl - _begin);
+        _begin = nl + 1;
+        return true;
+      }
+    }
+    if (!fill()) {
+      break;
+    }
+  }
+
+  // yield an unterminated last line, if any
+  if (_begin < _end) {
+    line = _begin;
+    length = static_cast<std::size_t>(_end - _begin);
+    _begin = _end;
+    return true;
+  }
+  return false;
+}
+
+/**
+ * Skip the given number of lines
+ *
+ * When no line terminator is found in the current window, the window is
+ * discarded altogether (there's no need to keep a line that will not be
+ * yielded), and the next terminator found is taken to end the line being
+ * skipped.
+ *
+ * @param n  Number of lines to skip
+ * @return the number of lines actually skipped (less than n only on end of input)
+ * @throws std::system_error in case reading fails
+ */
+std::size_t LineReader::skip(std::size_t n) {
+  std::size_t done = 0;
+
+  while (done < n) {
+    if (_begin < _end) {
+      char const *nl = static_cast<char const *>(std::memchr(_begin, '\n', static_cast<std::size_t>(_end - _begin)));
+      if (nullptr != nl) {
+        _begin = nl + 1;
+        _partial = false;
+        done++;
+        continue;
+      }
+      _partial = true;
+      _begin = _end;
+    }
+    if (!fill()) {
+      if (_partial) {
+        _partial = false;
+        done++;
+      }
+      break;
+    }
+  }
+
+  return done;
+}
+
+/**
+ * Determine whether the input is mapped in its entirety
+ *
+ * @return true if the whole input is accessible via data() and size()
+ */
+bool LineReader::mapped() const noexcept {
+  return nullptr != _map;
+}
+
+/**
+ * Retrieve a pointer to the whole mapped input
+ *
+ * @return a pointer to the input's first character (nullptr if not mapped)
+ */
+char const *LineReader::data() const noexcept {
+  return _map;
+}
+
+/**
+ * Retrieve the size of the whole mapped input
+ *
+ * @return the input's size in bytes (0 if not mapped)
+ */
+std::size_t LineReader::size() const noexcept {
+  return _mapSize;
+}
+
+
+/**
+ * Read another chunk, keeping the unconsumed part of the window
+ *
+ * The unconsumed part of the window is moved to the front of the buffer, and
+ * the buffer grown if needed so that a whole chunk can be read after it.
+ *
+ * @return false if no more data is available
+ * @throws std::system_error in case reading fails
+ */
+bool LineReader::fill() {
+  if (_eof) {
+    return false;
+  }
+
+  std::size_t keep = static_cast<std::size_t>(_end - _begin);
+  if (0 != keep && _buffer.data() != _begin) {
+    std::memmove(_buffer.data(), _begin, keep);
+  }
+  if (_buffer.size() < keep + chunkSize) {
+    _buffer.resize(keep + chunkSize);
+  }
+
+  ssize_t got;
+  do {
+    got = ::read(_fd, _buffer.data() + keep, _buffer.size() - keep);
+  } while (got < 0 && EINTR == errno);
+  if (got < 0) {
+    throw std::system_error(errno, std::system_category(), "Cannot read input");
+  }
+
+  _begin = _buffer.data();
+  _end = _begin + keep + static_cast<std::size_t>(got);
+  if (0 == got) {
+    _eof = true;
+    return false;
+  }
+  return true;
+}
+
+}
@@ -0,0 +1,175 @@
+#ifndef DRAUPNIR_LINE_READER_H__
+#define DRAUPNIR_LINE_READER_H__
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Draupnir {
+
+  /**
+   * Zero-copy line-oriented input
+   *
+   * This class yields the lines in a file (or in the standard input) as
+   * pointer and length pairs referring to an internal window, and allows for
+   * lines to be skipped without being materialized.
+   *
+   * Regular files are mmap'ed in their entirety, so that the window spans the
+   * whole file and every line yielded remains valid for the reader's
+   * lifetime; anything else (eg. pipes) is read in large sequential chunks,
+   * and a line yielded is only valid until the next call to next() or skip().
+   *
+   * Lines are separated by '\n', which is never included in the lines
+   * yielded; a last line lacking its terminator is yielded all the same.
+   *
+   */
+  class LineReader {
+    public:
+      /**
+       * Open the given file for reading
+       *
+       * @param path  Path to the file to read ("-" for the standard input)
+       * @throws std::system_error in case the file cannot be opened or mapped
+       */
+      explicit LineReader(std::string const &path);
+
+      /**
+       * Copy constructor - deleted
+       *
+       * @param other  LineReader to copy from
+       */
+      LineReader(LineReader const &other) = delete;
+
+      /**
+       * Assignment operator - deleted
+       *
+       * @param other  LineReader to assign
+       * @return the newly assigned LineReader
+       */
+      LineReader &operator=(LineReader const &other) = delete;
+
+      /**
+       * Destructor - unmap and close the underlying file
+       *
+       */
+      ~LineReader() noexcept;
+
+      /**
+       * Retrieve the next line
+       *
+       * @param line  Output pointer to the line's first character
+       * @param length  Output line length (excluding the line terminator)
+       * @return true if a line was retrieved, false on end of input
+       * @throws std::system_error in case reading fails
+       */
+      bool next(char const *&line, std::size_t &length);
+
+      /**
+       * Skip the given number of lines
+       *
+       * @param n  Number of lines to skip
+       * @return the number of lines actually skipped (less than n only on end of input)
+       * @throws std::system_error in case reading fails
+       */
+      std::size_t skip(std::size_t n);
+
+      /**
+       * Determine whether the input is mapped in its entirety
+       *
+       * @return true if the whole input is accessible via data() and size()
+       */
+      bool mapped() const noexcept __attribute__((pure));
+
+      /**
+       * Retrieve a pointer to the whole mapped input
+       *
+       * @return a pointer to the input's first character (nullptr if not mapped)
+       */
+      char const *data() const noexcept __attribute__((pure));
+
+      /**
+       * Retrieve the size of the whole mapped input
+       *
+       * @return the input's size in bytes (0 if not mapped)
+       */
+      std::size_t size() const noexcept __attribute__((pure));
+
+    protected:
+      /**
+       * Size of the chunks to read when not mapped
+       *
+       */
+      static constexpr std::size_t chunkSize = 1 << 20;
+
+      /**
+       * Size of the window at the start of a mapped file to request read-ahead for
+       *
+       */
+      static constexpr std::size_t readAheadSize = 1 << 24;
+
+      /**
+       * Read another chunk, keeping the unconsumed part of the window
+       *
+       * @return false if no more data is available
+       * @throws std::system_error in case reading fails
+       */
+      bool fill();
+
+      /**
+       * Mapped input (nullptr if not mapped)
+       *
+       */
+      char const *_map;
+
+      /**
+       * Size of the mapped input
+       *
+       */
+      std::size_t _mapSize;
+
+      /**
+       * Read buffer (unused if mapped)
+       *
+       */
+      std::vector<char> _buffer;
+
+      /**
+       * Start of the unconsumed window
+       *
+       */
+      char const *_begin;
+
+      /**
+       * End of the unconsumed window
+       *
+       */
+      char const *_end;
+
+      /**
+       * File descriptor to read from
+       *
+       */
+      int _fd;
+
+      /**
+       * Whether the file descriptor must be closed on destruction
+       *
+       */
+      bool _owned;
+
+      /**
+       * Whether the end of input has been reached
+       *
+       */
+      bool _eof;
+
+      /**
+       * Whether the window was discarded in the middle of a line while skipping
+       *
+       */
+      bool _partial;
+  };
+
+}
+
+#endif /* DRAUPNIR_LINE_READER_H__ */
@@ -0,0 +1,60 @@
+#ifndef DRAUPNIR_PARALLEL_SHUFFLE_H__
+#define DRAUPNIR_PARALLEL_SHUFFLE_H__
+
+#include <cstdint>
+
+#include "Sponge.h"
+
+namespace Draupnir {
+
+  namespace Random {
+
+    /**
+     * Shuffle the given range in place using a parallel MergeShuffle
+     *
+     * This function splits the range into a power-of-2 number of contiguous
+     * blocks, shuffles each block independently using Fisher--Yates, and then
+     * merges adjacent blocks pairwise, level by level, using Bacher et al.'s
+     * MergeShuffle merging procedure (which preserves uniformity); blocks
+     * (and merges within a level) are processed by a pool of threads.
+     *
+     * Every block and every merge draws from its own substream, derived from
+     * a clone of the given sponge and indexed by the block (or merge)
+     * position, so that the result is fully determined by the sponge's state
+     * and the range's length: neither the number of threads used nor their
+     * scheduling affect it. The given sponge is stepped once afterwards.
+     *
+     * Merges access memory sequentially (save for a short insertion tail), so
+     * that the whole process is cache and TLB friendly; the range may well
+     * be backed by an mmap'ed file.
+     *
+     * @param s  Sponge to use for randomization
+     * @param first  Iterator pointing to the first element to shuffle
+     * @param last  Iterator pointing past the last element to shuffle
+     * @param threads  Number of threads to use (0 to use the hardware concurrency)
+     */
+    template <typename RandomIt, typename S>
+    void parallelShuffle(S &s, RandomIt first, RandomIt last, std::size_t threads = 0);
+
+    /**
+     * Generate a random permutation into the given range using a parallel MergeShuffle
+     *
+     * This function fills the range with the numbers between 0 and n - 1
+     * inclusive (n being the range's length) and shuffles it as
+     * parallelShuffle does, filling each block right before shuffling it.
+     *
+     * @param s  Sponge to use for randomization
+     * @param first  Iterator pointing to the first element to fill
+     * @param last  Iterator pointing past the last element to fill
+     * @param threads  Number of threads to use (0 to use the hardware concurrency)
+     */
+    template <typename RandomIt, typename S>
+    void parallelPermutation(S &s, RandomIt first, RandomIt last, std::size_t threads = 0);
+
+  }
+
+}
+
+#include "ParallelShuffle.hpp"
+
+#endif /* DRAUPNIR_PARALLEL_SHUFFLE_H__ */
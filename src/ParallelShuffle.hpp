@@ -0,0 +1,160 @@
+#ifndef DRAUPNIR_PARALLEL_SHUFFLE_HPP__
+#define DRAUPNIR_PARALLEL_SHUFFLE_HPP__
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+
+#include "ParallelShuffle.h"
+#include "Random.h"
+#include "ThreadPool.h"
+
+namespace {
+
+  /**
+   * Smallest block size to split a range into
+   *
+   */
+  constexpr std::size_t mergeShuffleMinBlock = std::size_t(1) << 16;
+
+  /**
+   * Largest number of blocks to split a range into
+   *
+   */
+  constexpr std::size_t mergeShuffleMaxBlocks = std::size_t(1) << 12;
+
+  /**
+   * Merge two adjacent shuffled blocks into a single shuffled block
+   *
+   * A coin is flipped for each position: heads takes the next element from
+   * the second block (swapping it in), tails keeps the one from the first;
+   * once either block is exhausted, the remaining positions are each
+   * inserted at a uniformly random position among the ones before them.
+   *
+   * @param s  Sponge to use for randomization
+   * @param first  Iterator pointing to the first block's first element
+   * @param mid  Iterator pointing to the second block's first element
+   * @param last  Iterator pointing past the second block's last element
+   */
+  template <typename RandomIt, typename S>
+  void mergeShuffleMerge(S &s, RandomIt first, RandomIt mid, RandomIt last) {
+    RandomIt i = first, j = mid;
+    std::uint64_t bits = 0;
+    unsigned available = 0;
+
+    while (true) {
+      if (0 == available) {
+        bits = Draupnir::Random::natural<std::uint64_t>(s);
+        available = 64;
+      }
+      bool heads = 0 != (bits & 1);
+      bits >>= 1;
+      available--;
+
+      if (heads) {
+        if (j == last) {
+          break;
+        }
+        std::iter_swap(i, j);
+        ++j;
+      } else if (i == j) {
+        break;
+      }
+      ++i;
+    }
+
+    for (; i != last; ++i) {
+      std::size_t m = Draupnir::Random::natural<std::size_t>(s, static_cast<std::size_t>(i - first));
+      std::iter_swap(i, first + static_cast<std::ptrdiff_t>(m));
+    }
+  }
+
+  /**
+   * Perform a parallel MergeShuffle, preparing each block right before shuffling it
+   *
+   * Blocks draw from the substreams indexed 0 to blocks - 1, and the merge
+   * of pair p at level l (counting from 1) draws from the substream indexed
+   * l * 2^32 + p.
+   *
+   * @param s  Sponge to use for randomization
+   * @param first  Iterator pointing to the first element to shuffle
+   * @param last  Iterator pointing past the last element to shuffle
+   * @param threads  Number of threads to use (0 to use the hardware concurrency)
+   * @param prepare  Function to call on each block's first and last iterators, and first position, before shuffling it
+   */
+  template <typename RandomIt, typename S, typename F>
+  void mergeShuffle(S &s, RandomIt first, RandomIt last, std::size_t threads, F const &prepare) {
+    std::size_t n = static_cast<std::size_t>(last - first);
+
+    std::size_t blocks = 1;
+    while (blocks < mergeShuffleMaxBlocks && 2 * blocks * mergeShuffleMinBlock <= n) {
+      blocks *= 2;
+    }
+    auto bound = [n, blocks](std::size_t b) {
+      return static_cast<std::ptrdiff_t>(n / blocks * b + std::min(b, n % blocks));
+    };
+
+    std::unique_ptr<S> base(s.clone());
+    s.step();
+
+    Draupnir::ThreadPool pool(threads);
+    pool.run(blocks, [&](std::size_t from, std::size_t to) {
+      for (std::size_t b = from; b < to; b++) {
+        RandomIt lo = first + bound(b), hi = first + bound(b + 1);
+        prepare(lo, hi, static_cast<std::size_t>(bound(b)));
+        auto sub = Draupnir::Random::substream(*base, b);
+        Draupnir::Random::shuffle(*sub, lo, hi);
+      }
+    });
+
+    for (std::size_t width = 1, level = 1; width < blocks; width *= 2, level++) {
+      pool.run(blocks / (2 * width), [&](std::size_t from, std::size_t to) {
+        for (std::size_t p = from; p < to; p++) {
+          auto sub = Draupnir::Random::substream(*base, (level << 32) | p);
+          mergeShuffleMerge(*sub, first + bound(2 * p * width), first + bound((2 * p + 1) * width), first + bound((2 * p + 2) * width));
+        }
+      });
+    }
+  }
+
+}
+
+namespace Draupnir {
+
+  namespace Random {
+
+    /**
+     * Shuffle the given range in place using a parallel MergeShuffle
+     *
+     * @param s  Sponge to use for randomization
+     * @param first  Iterator pointing to the first element to shuffle
+     * @param last  Iterator pointing past the last element to shuffle
+     * @param threads  Number of threads to use (0 to use the hardware concurrency)
+     */
+    template <typename RandomIt, typename S>
+    void parallelShuffle(S &s, RandomIt first, RandomIt last, std::size_t threads) {
+      mergeShuffle(s, first, last, threads, [](RandomIt, RandomIt, std::size_t) {});
+    }
+
+    /**
+     * Generate a random permutation into the given range using a parallel MergeShuffle
+     *
+     * @param s  Sponge to use for randomization
+     * @param first  Iterator pointing to the first element to fill
+     * @param last  Iterator pointing past the last element to fill
+     * @param threads  Number of threads to use (0 to use the hardware concurrency)
+     */
+    template <typename RandomIt, typename S>
+    void parallelPermutation(S &s, RandomIt first, RandomIt last, std::size_t threads) {
+      mergeShuffle(s, first, last, threads, [](RandomIt lo, RandomIt hi, std::size_t k) {
+        for (; lo != hi; ++lo, k++) {
+          *lo = k;
+        }
+      });
+    }
+
+  }
+
+}
+
+#endif /* DRAUPNIR_PARALLEL_SHUFFLE_HPP__ */
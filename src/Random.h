@@ -1,7 +1,9 @@
 #ifndef DRAUPNIR_RANDOM_H__
 #define DRAUPNIR_RANDOM_H__
 
+#include <cstdint>
 #include <limits>
+#include <memory>
 #include <vector>
 
 #include "Sponge.h"
@@ -13,12 +15,91 @@ namespace Draupnir {
     /**
      * Extract a random number between 0 and the given limit of the templated length from the given sponge
      *
+     * As every function herein, this one is templated on the sponge type S,
+     * so that squeezing from a concrete sponge (eg. CrcSponge64) can be
+     * inlined; non-template functions additionally provide a type-erased
+     * overload taking a Draupnir::Sponge reference.
+     *
      * @param s  Sponge to use for randomization
      * @param high  Highest possible value to return
      * @return a random number between 0 and the given limit fitting in the templated length
      */
-    template <typename T>
-    T natural(Draupnir::Sponge &s, T high = std::numeric_limits<T>::max());
+    template <typename T, typename S>
+    T natural(S &s, T high = std::numeric_limits<T>::max());
+
+    /**
+     * Extract a random multi-limb number between 0 and the given limit from the given sponge
+     *
+     * Numbers are given as arrays of 64 bit limbs, least significant limb
+     * first; only as many bytes as needed to cover the limit's bit length are
+     * squeezed per attempt (the top limb being masked to it), limbs are drawn
+     * most significant first, and an attempt is abandoned as soon as it is
+     * known to exceed the limit, so that less than two attempts are needed on
+     * average, and no bias is introduced.
+     *
+     * @param s  Sponge to use for randomization
+     * @param high  Pointer to the highest possible value to return
+     * @param limbs  Number of limbs in both the limit and the output
+     * @param out  Pointer to the storage where to write the number generated
+     */
+    template <typename S>
+    void natural(S &s, std::uint64_t const *high, std::size_t limbs, std::uint64_t *out);
+
+    /**
+     * Extract a random multi-limb number between 0 and the given limit from the given sponge - type-erased
+     *
+     * This overload merely forwards to the sponge-type-templated one.
+     *
+     * @param s  Sponge to use for randomization
+     * @param high  Pointer to the highest possible value to return
+     * @param limbs  Number of limbs in both the limit and the output
+     * @param out  Pointer to the storage where to write the number generated
+     */
+    void natural(Draupnir::Sponge &s, std::uint64_t const *high, std::size_t limbs, std::uint64_t *out);
+
+    /**
+     * Extract the given number of random multi-limb numbers between 0 and the given limit from the given sponge
+     *
+     * This function behaves just as the single number one, but for the
+     * limit's bit length and top limb being analyzed only once; the numbers
+     * are written contiguously.
+     *
+     * @param s  Sponge to use for randomization
+     * @param high  Pointer to the highest possible value to return
+     * @param limbs  Number of limbs in both the limit and each output number
+     * @param out  Pointer to the storage where to write the numbers generated (of at least count * limbs limbs)
+     * @param count  Number of numbers to generate
+     */
+    template <typename S>
+    void natural(S &s, std::uint64_t const *high, std::size_t limbs, std::uint64_t *out, std::size_t count);
+
+    /**
+     * Extract the given number of random multi-limb numbers between 0 and the given limit from the given sponge - type-erased
+     *
+     * This overload merely forwards to the sponge-type-templated one.
+     *
+     * @param s  Sponge to use for randomization
+     * @param high  Pointer to the highest possible value to return
+     * @param limbs  Number of limbs in both the limit and each output number
+     * @param out  Pointer to the storage where to write the numbers generated (of at least count * limbs limbs)
+     * @param count  Number of numbers to generate
+     */
+    void natural(Draupnir::Sponge &s, std::uint64_t const *high, std::size_t limbs, std::uint64_t *out, std::size_t count);
+
+    /**
+     * Derive a substream from the given sponge
+     *
+     * The substream is a clone of the given sponge with the given index
+     * soaked into it, so that it is fully determined by the sponge's state and
+     * the index, and distinct indices yield unrelated streams; the given
+     * sponge is left untouched.
+     *
+     * @param s  Sponge to derive the substream from
+     * @param index  Substream index
+     * @return a pointer to the newly derived substream
+     */
+    template <typename S>
+    std::unique_ptr<S> substream(S const &s, std::size_t index);
 
     /**
      * Generate a random real value between 0 and 1
@@ -26,8 +107,299 @@ namespace Draupnir {
      * @param s  Sponge to use for randomization
      * @return the real number generated
      */
+    template <typename S>
+    long double real(S &s);
+
+    /**
+     * Generate a random real value between 0 and 1 - type-erased
+     *
+     * This overload merely forwards to the sponge-type-templated one.
+     *
+     * @param s  Sponge to use for randomization
+     * @return the real number generated
+     */
     long double real(Draupnir::Sponge &s);
 
+    /**
+     * Generate a random real value strictly between 0 and 1
+     *
+     * This function never yields either endpoint, so that its result can be
+     * safely fed to logarithms and divisions.
+     *
+     * @param s  Sponge to use for randomization
+     * @return the real number generated
+     */
+    template <typename S>
+    double openReal(S &s);
+
+    /**
+     * Generate a random real value strictly between 0 and 1 - type-erased
+     *
+     * This overload merely forwards to the sponge-type-templated one.
+     *
+     * @param s  Sponge to use for randomization
+     * @return the real number generated
+     */
+    double openReal(Draupnir::Sponge &s);
+
+    /**
+     * Generate a random real value following the standard normal distribution
+     *
+     * This function uses the ziggurat method: the fast path (taken about 99%
+     * of the time) consumes a single 64 bit word and involves no
+     * transcendental function evaluation.
+     *
+     * @param s  Sponge to use for randomization
+     * @return the real number generated
+     */
+    template <typename S>
+    double normal(S &s);
+
+    /**
+     * Generate a random real value following the standard normal distribution - type-erased
+     *
+     * This overload merely forwards to the sponge-type-templated one.
+     *
+     * @param s  Sponge to use for randomization
+     * @return the real number generated
+     */
+    double normal(Draupnir::Sponge &s);
+
+    /**
+     * Fill the given range with random real values following the given normal distribution
+     *
+     * @param s  Sponge to use for randomization
+     * @param first  Iterator pointing to the first element to fill
+     * @param last  Iterator pointing past the last element to fill
+     * @param mean  Distribution's mean (defaults to 0)
+     * @param stddev  Distribution's standard deviation (defaults to 1)
+     */
+    template <typename ForwardIt, typename S>
+    void normal(S &s, ForwardIt first, ForwardIt last, double mean = 0.0, double stddev = 1.0);
+
+    /**
+     * Generate a random real value following the standard exponential distribution
+     *
+     * This function uses the ziggurat method: the fast path (taken about 98%
+     * of the time) consumes a single 64 bit word and involves no
+     * transcendental function evaluation.
+     *
+     * @param s  Sponge to use for randomization
+     * @return the real number generated
+     */
+    template <typename S>
+    double exponential(S &s);
+
+    /**
+     * Generate a random real value following the standard exponential distribution - type-erased
+     *
+     * This overload merely forwards to the sponge-type-templated one.
+     *
+     * @param s  Sponge to use for randomization
+     * @return the real number generated
+     */
+    double exponential(Draupnir::Sponge &s);
+
+    /**
+     * Fill the given range with random real values following the given exponential distribution
+     *
+     * @param s  Sponge to use for randomization
+     * @param first  Iterator pointing to the first element to fill
+     * @param last  Iterator pointing past the last element to fill
+     * @param rate  Distribution's rate (ie. the inverse of its mean, defaults to 1)
+     */
+    template <typename ForwardIt, typename S>
+    void exponential(S &s, ForwardIt first, ForwardIt last, double rate = 1.0);
+
+    /**
+     * Generate a random real value following the gamma distribution with the given shape and unit scale
+     *
+     * This function uses Marsaglia and Tsang's method on top of normal().
+     *
+     * @param s  Sponge to use for randomization
+     * @param shape  Distribution's shape (must be positive)
+     * @return the real number generated
+     */
+    template <typename S>
+    double gamma(S &s, double shape);
+
+    /**
+     * Generate a random real value following the gamma distribution with the given shape and unit scale - type-erased
+     *
+     * This overload merely forwards to the sponge-type-templated one.
+     *
+     * @param s  Sponge to use for randomization
+     * @param shape  Distribution's shape (must be positive)
+     * @return the real number generated
+     */
+    double gamma(Draupnir::Sponge &s, double shape);
+
+    /**
+     * Fill the given range with random real values following the given gamma distribution
+     *
+     * @param s  Sponge to use for randomization
+     * @param first  Iterator pointing to the first element to fill
+     * @param last  Iterator pointing past the last element to fill
+     * @param shape  Distribution's shape (must be positive)
+     * @param scale  Distribution's scale (defaults to 1)
+     */
+    template <typename ForwardIt, typename S>
+    void gamma(S &s, ForwardIt first, ForwardIt last, double shape, double scale = 1.0);
+
+    /**
+     * Generate a random natural number following the Poisson distribution with the given mean
+     *
+     * This function uses Hörmann's PTRS (ie. transformed rejection with
+     * squeeze) for means of 10 and above, and inversion by sequential search
+     * (from a single uniform draw) below that; both take constant expected
+     * time.
+     *
+     * @param s  Sponge to use for randomization
+     * @param mean  Distribution's mean (must be non-negative)
+     * @return the natural number generated
+     */
+    template <typename S>
+    std::size_t poisson(S &s, double mean);
+
+    /**
+     * Generate a random natural number following the Poisson distribution with the given mean - type-erased
+     *
+     * This overload merely forwards to the sponge-type-templated one.
+     *
+     * @param s  Sponge to use for randomization
+     * @param mean  Distribution's mean (must be non-negative)
+     * @return the natural number generated
+     */
+    std::size_t poisson(Draupnir::Sponge &s, double mean);
+
+    /**
+     * Fill the given range with random natural numbers following the Poisson distribution with the given mean
+     *
+     * The distribution's setup is performed only once for the whole range.
+     *
+     * @param s  Sponge to use for randomization
+     * @param first  Iterator pointing to the first element to fill
+     * @param last  Iterator pointing past the last element to fill
+     * @param mean  Distribution's mean (must be non-negative)
+     */
+    template <typename ForwardIt, typename S>
+    void poisson(S &s, ForwardIt first, ForwardIt last, double mean);
+
+    /**
+     * Generate a random natural number following the binomial distribution with the given parameters
+     *
+     * This function uses Hörmann's BTRD (ie. transformed rejection with
+     * decomposition) whenever n * min(p, 1 - p) is 10 or above, and inversion
+     * by sequential search (from a single uniform draw) below that; both take
+     * constant expected time.
+     *
+     * @param s  Sponge to use for randomization
+     * @param n  Number of trials
+     * @param p  Success probability of each trial
+     * @return the natural number generated
+     */
+    template <typename S>
+    std::size_t binomial(S &s, std::size_t n, double p);
+
+    /**
+     * Generate a random natural number following the binomial distribution with the given parameters - type-erased
+     *
+     * This overload merely forwards to the sponge-type-templated one.
+     *
+     * @param s  Sponge to use for randomization
+     * @param n  Number of trials
+     * @param p  Success probability of each trial
+     * @return the natural number generated
+     */
+    std::size_t binomial(Draupnir::Sponge &s, std::size_t n, double p);
+
+    /**
+     * Fill the given range with random natural numbers following the binomial distribution with the given parameters
+     *
+     * The distribution's setup is performed only once for the whole range.
+     *
+     * @param s  Sponge to use for randomization
+     * @param first  Iterator pointing to the first element to fill
+     * @param last  Iterator pointing past the last element to fill
+     * @param n  Number of trials
+     * @param p  Success probability of each trial
+     */
+    template <typename ForwardIt, typename S>
+    void binomial(S &s, ForwardIt first, ForwardIt last, std::size_t n, double p);
+
+    /**
+     * Generate a random natural number following the geometric distribution with the given success probability
+     *
+     * The number generated is the number of failures before the first
+     * success, obtained by inversion from a single uniform draw.
+     *
+     * @param s  Sponge to use for randomization
+     * @param p  Success probability of each trial
+     * @return the natural number generated (saturated to the largest std::size_t value)
+     */
+    template <typename S>
+    std::size_t geometric(S &s, double p);
+
+    /**
+     * Generate a random natural number following the geometric distribution with the given success probability - type-erased
+     *
+     * This overload merely forwards to the sponge-type-templated one.
+     *
+     * @param s  Sponge to use for randomization
+     * @param p  Success probability of each trial
+     * @return the natural number generated (saturated to the largest std::size_t value)
+     */
+    std::size_t geometric(Draupnir::Sponge &s, double p);
+
+    /**
+     * Fill the given range with random natural numbers following the geometric distribution with the given success probability
+     *
+     * @param s  Sponge to use for randomization
+     * @param first  Iterator pointing to the first element to fill
+     * @param last  Iterator pointing past the last element to fill
+     * @param p  Success probability of each trial
+     */
+    template <typename ForwardIt, typename S>
+    void geometric(S &s, ForwardIt first, ForwardIt last, double p);
+
+    /**
+     * Generate a random vector of counts following the multinomial distribution with the given parameters
+     *
+     * This function draws each count from a binomial distribution conditioned
+     * on the counts drawn before it, so that it takes constant expected time
+     * per category.
+     *
+     * @param s  Sponge to use for randomization
+     * @param n  Number of trials
+     * @param first  Iterator pointing to the first category's weight (weights need not be normalized)
+     * @param last  Iterator pointing past the last category's weight
+     * @param out  Iterator to write the counts to (one per category)
+     * @return the iterator pointing past the last count written
+     */
+    template <typename ForwardIt, typename OutputIt, typename S>
+    OutputIt multinomial(S &s, std::size_t n, ForwardIt first, ForwardIt last, OutputIt out);
+
+    /**
+     * Fill the given range of words with independent random bits, each set with the given probability
+     *
+     * Bit k of the word at position w stands for the (64 w + k)-th bit
+     * generated.
+     *
+     * Dense bitmaps are generated a word at a time by lazily comparing 64
+     * uniform binary expansions (one per bit, each digit coming from a fresh
+     * squeezed word) against p's, so that about log2(64) + 2 words are drawn
+     * per word generated; sparse bitmaps (ie. p or 1 - p below 1/16) are
+     * generated by geometric skipping, taking a single draw per exceptional
+     * bit.
+     *
+     * @param s  Sponge to use for randomization
+     * @param p  Probability of each bit being set
+     * @param first  Iterator pointing to the first word to fill
+     * @param last  Iterator pointing past the last word to fill
+     */
+    template <typename RandomIt, typename S>
+    void bernoulliBits(S &s, double p, RandomIt first, RandomIt last);
+
     /**
      * Generate a random permutation of the given size
      *
@@ -39,8 +411,34 @@ namespace Draupnir {
      * @param size  Permutation size
      * @return a std::vector containing the generated permutation
      */
+    template <typename S>
+    std::vector<std::size_t> permutation(S &s, std::size_t size);
+
+    /**
+     * Generate a random permutation of the given size - type-erased
+     *
+     * This overload merely forwards to the sponge-type-templated one.
+     *
+     * @param s  Sponge to use for randomization
+     * @param size  Permutation size
+     * @return a std::vector containing the generated permutation
+     */
     std::vector<std::size_t> permutation(Draupnir::Sponge &s, std::size_t size);
 
+    /**
+     * Generate a random permutation into the given range
+     *
+     * This function generates a random permutation of the numbers between 0
+     * and n - 1 inclusive (n being the range's length) using the "inside-out"
+     * Fisher--Yates shuffling algorithm; no allocation is performed.
+     *
+     * @param s  Sponge to use for randomization
+     * @param first  Iterator pointing to the first element to fill
+     * @param last  Iterator pointing past the last element to fill
+     */
+    template <typename RandomIt, typename S>
+    void permutation(S &s, RandomIt first, RandomIt last);
+
     /**
      * Generate a random cyclic permutation of the given size
      *
@@ -52,42 +450,328 @@ namespace Draupnir {
      * @param size  Permutation size
      * @return a std::vector containing the generated permutation
      */
+    template <typename S>
+    std::vector<std::size_t> cycle(S &s, std::size_t size);
+
+    /**
+     * Generate a random cyclic permutation of the given size - type-erased
+     *
+     * This overload merely forwards to the sponge-type-templated one.
+     *
+     * @param s  Sponge to use for randomization
+     * @param size  Permutation size
+     * @return a std::vector containing the generated permutation
+     */
     std::vector<std::size_t> cycle(Draupnir::Sponge &s, std::size_t size);
 
+    /**
+     * Generate a random cyclic permutation into the given range
+     *
+     * This function generates a random cyclic permutation of the numbers
+     * between 0 and n - 1 inclusive (n being the range's length) using the
+     * "inside-out" Sattolo shuffling algorithm; no allocation is performed.
+     *
+     * @param s  Sponge to use for randomization
+     * @param first  Iterator pointing to the first element to fill
+     * @param last  Iterator pointing past the last element to fill
+     */
+    template <typename RandomIt, typename S>
+    void cycle(S &s, RandomIt first, RandomIt last);
+
+    /**
+     * Shuffle the given range in place
+     *
+     * This function shuffles the given range using the Fisher--Yates
+     * shuffling algorithm, drawing bounded swap targets in batches and
+     * prefetching them a window ahead of the swaps proper.
+     *
+     * @param s  Sponge to use for randomization
+     * @param first  Iterator pointing to the first element to shuffle
+     * @param last  Iterator pointing past the last element to shuffle
+     */
+    template <typename RandomIt, typename S>
+    void shuffle(S &s, RandomIt first, RandomIt last);
+
     /**
      * Generate a random derangement of the given size
      *
-     * This function generates a random permutation of the given size using the
-     * Fisher--Yates shuffling algorithm and applying rejection to the result;
-     * the derangement's elements will be the numbers between 0 and size - 1
-     * inclusive.
+     * This function generates a random derangement of the given size directly,
+     * using Martínez, Panholzer and Prodinger's algorithm; the derangement's
+     * elements will be the numbers between 0 and size - 1 inclusive.
      *
      * @param s  Sponge to use for randomization
-     * @param size  Permutation size
+     * @param size  Permutation size (must not be 1)
+     * @return a std::vector containing the generated permutation
+     * @throws std::domain_error in case size is 1
+     */
+    template <typename S>
+    std::vector<std::size_t> derangement(S &s, std::size_t size);
+
+    /**
+     * Generate a random derangement of the given size - type-erased
+     *
+     * This overload merely forwards to the sponge-type-templated one.
+     *
+     * @param s  Sponge to use for randomization
+     * @param size  Permutation size (must not be 1)
      * @return a std::vector containing the generated permutation
+     * @throws std::domain_error in case size is 1
      */
     std::vector<std::size_t> derangement(Draupnir::Sponge &s, std::size_t size);
 
+    /**
+     * Determine the scratch size needed for a derangement of the given size
+     *
+     * @param size  Permutation size
+     * @return the number of std::size_t elements of scratch space needed
+     */
+    std::size_t derangementScratchSize(std::size_t size) noexcept;
+
+    /**
+     * Generate a random derangement into the given range
+     *
+     * This function generates a random derangement of the numbers between 0
+     * and n - 1 inclusive (n being the range's length) directly, using
+     * Martínez, Panholzer and Prodinger's algorithm: it takes about 2n random
+     * draws on average, with bounded variance, and no allocation is
+     * performed.
+     *
+     * @param s  Sponge to use for randomization
+     * @param first  Iterator pointing to the first element to fill
+     * @param last  Iterator pointing past the last element to fill (the range's length must not be 1)
+     * @param scratch  Scratch space (of at least derangementScratchSize(last - first) elements)
+     * @throws std::domain_error in case the range's length is 1
+     */
+    template <typename RandomIt, typename S>
+    void derangement(S &s, RandomIt first, RandomIt last, std::size_t *scratch);
+
     /**
      * Generate a uniform sampling with replacement (ie. simply a vector of random naturals)
      *
      * @param s  Sponge to use for randomization
-     * @param total  Total number to sample from
+     * @param total  Total number to sample from (must be positive)
      * @param size  Sample size to generate
      * @return a vector holding the sample
+     * @throws std::domain_error in case total is 0 and a non-empty sample is requested
+     */
+    template <typename S>
+    std::vector<std::size_t> uniformSampleWithReplacement(S &s, std::size_t total, std::size_t size);
+
+    /**
+     * Generate a uniform sampling with replacement (ie. simply a vector of random naturals) - type-erased
+     *
+     * This overload merely forwards to the sponge-type-templated one.
+     *
+     * @param s  Sponge to use for randomization
+     * @param total  Total number to sample from (must be positive)
+     * @param size  Sample size to generate
+     * @return a vector holding the sample
+     * @throws std::domain_error in case total is 0 and a non-empty sample is requested
      */
     std::vector<std::size_t> uniformSampleWithReplacement(Draupnir::Sponge &s, std::size_t total, std::size_t size);
 
     /**
-     * Generate a uniform sampling without replacement using reservoir sampling
+     * Generate a uniform sampling with replacement into the given range
      *
      * @param s  Sponge to use for randomization
-     * @param total  Total number to sample from
+     * @param total  Total number to sample from (must be positive)
+     * @param first  Iterator pointing to the first element to fill
+     * @param last  Iterator pointing past the last element to fill
+     * @throws std::domain_error in case total is 0 and a non-empty sample is requested
+     */
+    template <typename ForwardIt, typename S>
+    void uniformSampleWithReplacement(S &s, std::size_t total, ForwardIt first, ForwardIt last);
+
+    /**
+     * Determine the scratch size needed for a sampling without replacement of the given size
+     *
      * @param size  Sample size to generate
+     * @return the number of std::size_t elements of scratch space needed
+     */
+    std::size_t sampleScratchSize(std::size_t size) noexcept;
+
+    /**
+     * Generate a uniform sampling without replacement
+     *
+     * This function dispatches on the sample's density: sparse samples are
+     * generated using Floyd's algorithm, while dense ones are generated using
+     * reservoir sampling.
+     *
+     * @param s  Sponge to use for randomization
+     * @param total  Total number to sample from
+     * @param size  Sample size to generate (clamped to total)
+     * @return a vector holding the sample
+     */
+    template <typename S>
+    std::vector<std::size_t> uniformSampleWithoutReplacement(S &s, std::size_t total, std::size_t size);
+
+    /**
+     * Generate a uniform sampling without replacement - type-erased
+     *
+     * This overload merely forwards to the sponge-type-templated one.
+     *
+     * @param s  Sponge to use for randomization
+     * @param total  Total number to sample from
+     * @param size  Sample size to generate (clamped to total)
      * @return a vector holding the sample
      */
     std::vector<std::size_t> uniformSampleWithoutReplacement(Draupnir::Sponge &s, std::size_t total, std::size_t size);
 
+    /**
+     * Generate a uniform sampling without replacement into the given range
+     *
+     * This function dispatches on the sample's density just as the vector
+     * returning one does; no allocation is performed.
+     *
+     * @param s  Sponge to use for randomization
+     * @param total  Total number to sample from
+     * @param first  Iterator pointing to the first element to fill
+     * @param last  Iterator pointing past the last element to fill (the sample size is clamped to total)
+     * @param scratch  Scratch space (of at least sampleScratchSize(last - first) elements)
+     * @return an iterator pointing past the last element written
+     */
+    template <typename RandomIt, typename S>
+    RandomIt uniformSampleWithoutReplacement(S &s, std::size_t total, RandomIt first, RandomIt last, std::size_t *scratch);
+
+    /**
+     * Generate a uniform sampling without replacement using reservoir sampling
+     *
+     * This function takes O(total) time and random draws.
+     *
+     * @param s  Sponge to use for randomization
+     * @param total  Total number to sample from
+     * @param size  Sample size to generate (clamped to total)
+     * @return a vector holding the sample
+     */
+    template <typename S>
+    std::vector<std::size_t> reservoirSampleWithoutReplacement(S &s, std::size_t total, std::size_t size);
+
+    /**
+     * Generate a uniform sampling without replacement using reservoir sampling - type-erased
+     *
+     * This overload merely forwards to the sponge-type-templated one.
+     *
+     * @param s  Sponge to use for randomization
+     * @param total  Total number to sample from
+     * @param size  Sample size to generate (clamped to total)
+     * @return a vector holding the sample
+     */
+    std::vector<std::size_t> reservoirSampleWithoutReplacement(Draupnir::Sponge &s, std::size_t total, std::size_t size);
+
+    /**
+     * Generate a uniform sampling without replacement into the given range using reservoir sampling
+     *
+     * @param s  Sponge to use for randomization
+     * @param total  Total number to sample from
+     * @param first  Iterator pointing to the first element to fill
+     * @param last  Iterator pointing past the last element to fill (the sample size is clamped to total)
+     * @return an iterator pointing past the last element written
+     */
+    template <typename RandomIt, typename S>
+    RandomIt reservoirSampleWithoutReplacement(S &s, std::size_t total, RandomIt first, RandomIt last);
+
+    /**
+     * Generate a uniform sampling without replacement using Floyd's algorithm
+     *
+     * This function takes O(size) expected time and exactly size random
+     * draws, keeping the elements chosen so far in an open-addressing hash set.
+     *
+     * @param s  Sponge to use for randomization
+     * @param total  Total number to sample from
+     * @param size  Sample size to generate (clamped to total)
+     * @return a vector holding the sample
+     */
+    template <typename S>
+    std::vector<std::size_t> floydSampleWithoutReplacement(S &s, std::size_t total, std::size_t size);
+
+    /**
+     * Generate a uniform sampling without replacement using Floyd's algorithm - type-erased
+     *
+     * This overload merely forwards to the sponge-type-templated one.
+     *
+     * @param s  Sponge to use for randomization
+     * @param total  Total number to sample from
+     * @param size  Sample size to generate (clamped to total)
+     * @return a vector holding the sample
+     */
+    std::vector<std::size_t> floydSampleWithoutReplacement(Draupnir::Sponge &s, std::size_t total, std::size_t size);
+
+    /**
+     * Generate a uniform sampling without replacement into the given range using Floyd's algorithm
+     *
+     * The hash set of elements chosen so far is kept in the given scratch
+     * space.
+     *
+     * @param s  Sponge to use for randomization
+     * @param total  Total number to sample from
+     * @param first  Iterator pointing to the first element to fill
+     * @param last  Iterator pointing past the last element to fill (the sample size is clamped to total)
+     * @param scratch  Scratch space (of at least sampleScratchSize(last - first) elements)
+     * @return an iterator pointing past the last element written
+     */
+    template <typename RandomIt, typename S>
+    RandomIt floydSampleWithoutReplacement(S &s, std::size_t total, RandomIt first, RandomIt last, std::size_t *scratch);
+
+    /**
+     * Generate a sorted uniform sampling without replacement as a stream
+     *
+     * This function writes the sample in ascending order using Vitter's
+     * Algorithm D (ie. drawing the number of elements to skip before the next
+     * one sampled, in O(1) expected time each), switching to Algorithm A once
+     * the sample is no longer sparse, so that O(size) time and O(1) extra
+     * memory are needed.
+     *
+     * @param s  Sponge to use for randomization
+     * @param total  Total number to sample from
+     * @param size  Sample size to generate (clamped to total)
+     * @param out  Iterator pointing to the first element to write
+     * @return an iterator pointing past the last element written
+     */
+    template <typename OutputIt, typename S>
+    OutputIt sortedSampleWithoutReplacement(S &s, std::size_t total, std::size_t size, OutputIt out);
+
+    /**
+     * Generate a sorted uniform sampling with replacement as a stream
+     *
+     * This function writes the sample in ascending order by scaling sorted
+     * uniform reals (see sortedReal), so that O(size) time and O(1) extra
+     * memory are needed.
+     *
+     * @param s  Sponge to use for randomization
+     * @param total  Total number to sample from
+     * @param size  Sample size to generate
+     * @param out  Iterator pointing to the first element to write
+     * @return an iterator pointing past the last element written
+     */
+    template <typename OutputIt, typename S>
+    OutputIt sortedSampleWithReplacement(S &s, std::size_t total, std::size_t size, OutputIt out);
+
+    /**
+     * Generate the given number of sorted random real values between 0 and 1 as a stream
+     *
+     * This function writes the order statistics of size independent uniform
+     * reals in ascending order, by way of Rényi's representation: the i-th
+     * smallest of size standard exponentials is the sum of the first i
+     * independent exponential spacings, the j-th one scaled by
+     * 1 / (size - j + 1), and mapping them through 1 - e^(-x) yields uniform
+     * order statistics; O(size) time and O(1) extra memory are needed.
+     *
+     * @param s  Sponge to use for randomization
+     * @param size  Number of values to generate
+     * @param out  Iterator pointing to the first element to write
+     * @return an iterator pointing past the last element written
+     */
+    template <typename OutputIt, typename S>
+    OutputIt sortedReal(S &s, std::size_t size, OutputIt out);
+
+    /**
+     * Determine the scratch size needed for a non-uniform sampling with replacement over the given number of parts
+     *
+     * @param count  Number of parts in the distribution
+     * @return the number of std::size_t elements of scratch space needed
+     */
+    std::size_t aliasScratchSize(std::size_t count) noexcept;
+
     /**
      * Generate a non-uniform sampling with replacement (ie. simply a vector of number yielded from a Vose method)
      *
@@ -96,18 +780,73 @@ namespace Draupnir {
      * @param size  Sample size to generate
      * @return a vector holding the sample
      */
+    template <typename S>
+    std::vector<std::size_t> nonUniformSampleWithReplacement(S &s, std::vector<std::size_t> const &parts, std::size_t size);
+
+    /**
+     * Generate a non-uniform sampling with replacement (ie. simply a vector of number yielded from a Vose method) - type-erased
+     *
+     * This overload merely forwards to the sponge-type-templated one.
+     *
+     * @param s  Sponge to use for randomization
+     * @param parts  Distribution specified as parts-to-parts
+     * @param size  Sample size to generate
+     * @return a vector holding the sample
+     */
     std::vector<std::size_t> nonUniformSampleWithReplacement(Draupnir::Sponge &s, std::vector<std::size_t> const &parts, std::size_t size);
 
+    /**
+     * Generate a non-uniform sampling with replacement into the given range
+     *
+     * The alias table (and the work lists used to build it) are kept in the
+     * given scratch space.
+     *
+     * @param s  Sponge to use for randomization
+     * @param partsFirst  Iterator pointing to the first part in the distribution (specified as parts-to-parts)
+     * @param partsLast  Iterator pointing past the last part in the distribution
+     * @param first  Iterator pointing to the first element to fill
+     * @param last  Iterator pointing past the last element to fill
+     * @param scratch  Scratch space (of at least aliasScratchSize(partsLast - partsFirst) elements)
+     */
+    template <typename PartsIt, typename ForwardIt, typename S>
+    void nonUniformSampleWithReplacement(S &s, PartsIt partsFirst, PartsIt partsLast, ForwardIt first, ForwardIt last, std::size_t *scratch);
+
     /**
      * Generate a non-uniform sampling without replacement using Chao's method
      *
      * @param s  Sponge to use for randomization
      * @param parts  Distribution specified as parts-to-parts
-     * @param size  Sample size to generate
+     * @param size  Sample size to generate (clamped to the number of parts)
+     * @return a vector holding the sample
+     */
+    template <typename S>
+    std::vector<std::size_t> nonUniformSampleWithoutReplacement(S &s, std::vector<std::size_t> const &parts, std::size_t size);
+
+    /**
+     * Generate a non-uniform sampling without replacement using Chao's method - type-erased
+     *
+     * This overload merely forwards to the sponge-type-templated one.
+     *
+     * @param s  Sponge to use for randomization
+     * @param parts  Distribution specified as parts-to-parts
+     * @param size  Sample size to generate (clamped to the number of parts)
      * @return a vector holding the sample
      */
     std::vector<std::size_t> nonUniformSampleWithoutReplacement(Draupnir::Sponge &s, std::vector<std::size_t> const &parts, std::size_t size);
 
+    /**
+     * Generate a non-uniform sampling without replacement into the given range using Chao's method
+     *
+     * @param s  Sponge to use for randomization
+     * @param partsFirst  Iterator pointing to the first part in the distribution (specified as parts-to-parts)
+     * @param partsLast  Iterator pointing past the last part in the distribution
+     * @param first  Iterator pointing to the first element to fill
+     * @param last  Iterator pointing past the last element to fill (the sample size is clamped to the number of parts)
+     * @return an iterator pointing past the last element written
+     */
+    template <typename PartsIt, typename RandomIt, typename S>
+    RandomIt nonUniformSampleWithoutReplacement(S &s, PartsIt partsFirst, PartsIt partsLast, RandomIt first, RandomIt last);
+
   }
 
 }
@@ -115,4 +854,3 @@ namespace Draupnir {
 #include "Random.hpp"
 
 #endif /* DRAUPNIR_RANDOM_H__ */
-
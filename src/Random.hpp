@@ -1,9 +1,17 @@
 #ifndef DRAUPNIR_RANDOM_HPP__
 #define DRAUPNIR_RANDOM_HPP__
 
-#include <stack>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
 
 #include "Random.h"
+#include "Ziggurat.h"
 
 namespace {
 
@@ -13,8 +21,8 @@ namespace {
    * @param s  Sponge to use for randomization
    * @return a random number fitting in the templated length
    */
-  template <typename T>
-  T rand(Draupnir::Sponge &s) {
+  template <typename T, typename S>
+  T rand(S &s) {
     T result = static_cast<T>(0);
     for (std::size_t i = 0; i < std::numeric_limits<T>::digits; i += 8) {
       result = static_cast<T>((result << 8) | s.squeeze());
@@ -23,169 +31,1827 @@ namespace {
   }
 
   /**
-   * Determine whether the given vector holds a derangement
+   * Extract a random limb from the given number of bytes squeezed from the given sponge
    *
-   * This function assumes that the vector holds a permutation of the numbers
-   * from 0 to size - 1.
+   * The bytes are squeezed in bulk and composed most significant first, just
+   * as rand() does.
    *
-   * @param x  The vector to check
-   * @return true if x[i] != i holds for every 0 <= i < size
+   * @param s  Sponge to use for randomization
+   * @param bytes  Number of bytes to squeeze (at most 8)
+   * @return a random limb having (at most) the given number of lower bytes set
+   */
+  template <typename S>
+  std::uint64_t squeezeLimb(S &s, std::size_t bytes) {
+    std::uint8_t data[8];
+    s.squeeze(data, bytes);
+    std::uint64_t result = 0;
+    for (std::size_t i = 0; i < bytes; i++) {
+      result = (result << 8) | data[i];
+    }
+    return result;
+  }
+
+  /**
+   * Open-addressing hash set of indices over caller-provided storage
+   *
+   * This set uses linear probing over a power-of-2 sized table, hashing by
+   * Fibonacci multiplication; the largest std::size_t value is reserved to
+   * mark empty slots.
+   *
+   */
+  class IndexSet {
+    public:
+      /**
+       * Determine the table size to use in order to hold the given number of elements
+       *
+       * @param count  Maximum number of elements to hold
+       * @return the table size needed (a power of 2, keeping the load factor at most 1/2)
+       */
+      static std::size_t capacityFor(std::size_t count) noexcept {
+        std::size_t capacity = 2;
+        while (capacity < 2 * count) {
+          capacity <<= 1;
+        }
+        return capacity;
+      }
+
+      /**
+       * Construct an empty set over the given table
+       *
+       * @param table  Table to use (its contents will be overwritten)
+       * @param capacity  Table size (must be a power of 2, as returned by capacityFor)
+       */
+      IndexSet(std::size_t *table, std::size_t capacity) noexcept : _table{table}, _mask{capacity - 1}, _shift{64} {
+        for (std::size_t c = capacity; 1 < c; c >>= 1) {
+          _shift--;
+        }
+        std::fill(_table, _table + capacity, empty);
+      }
+
+      /**
+       * Insert the given index into the set
+       *
+       * @param x  Index to insert (must not be the largest std::size_t value)
+       * @return true if x was not already present
+       */
+      bool insert(std::size_t x) noexcept {
+        std::size_t i = ((x * 0x9e3779b97f4a7c15ull) >> _shift) & _mask;
+        while (empty != _table[i]) {
+          if (x == _table[i]) {
+            return false;
+          }
+          i = (i + 1) & _mask;
+        }
+        _table[i] = x;
+        return true;
+      }
+
+    protected:
+      /**
+       * Empty slot marker
+       *
+       */
+      static constexpr std::size_t empty = std::numeric_limits<std::size_t>::max();
+
+      /**
+       * Underlying table
+       *
+       */
+      std::size_t *_table;
+
+      /**
+       * Mask to apply to table positions
+       *
+       */
+      std::size_t _mask;
+
+      /**
+       * Shift to apply to the hash in order to keep its topmost bits
+       *
+       */
+      std::size_t _shift;
+  };
+
+  constexpr std::size_t IndexSet::empty;
+
+  /**
+   * Compute the Stirling series correction term for log(k!)
+   *
+   * This is log(k!) - ((k + 1/2) log(k + 1) - (k + 1) + log(2 pi) / 2),
+   * tabulated for small k and given by its asymptotic series otherwise.
+   *
+   * @param k  Number to compute the correction for
+   * @return the correction term
+   */
+  inline double stirlingCorrection(std::size_t k) noexcept {
+    static constexpr double table[10] = {
+      8.10614667953273305e-02, 4.13406959554094566e-02, 2.76779256849977173e-02, 2.07906721037658393e-02, 1.66446911898212591e-02,
+      1.38761288230728752e-02, 1.18967099458933134e-02, 1.04112652619736679e-02, 9.25546218270945076e-03, 8.33056343335947247e-03,
+    };
+    if (k < 10) {
+      return table[k];
+    }
+    double k1 = static_cast<double>(k + 1);
+    double k2 = k1 * k1;
+    return (1.0 / 12.0 - (1.0 / 360.0 - 1.0 / 1260.0 / k2) / k2) / k1;
+  }
+
+  /**
+   * Poisson generator holding the setup for a given mean
+   *
+   */
+  class PoissonGenerator {
+    public:
+      /**
+       * Perform the setup for the given mean
+       *
+       * @param mean  Distribution's mean (must be non-negative)
+       */
+      explicit PoissonGenerator(double mean) noexcept : _mean{mean}, _base{0.0}, _a{0.0}, _b{0.0}, _logInvAlpha{0.0}, _vr{0.0}, _logMean{0.0} {
+        if (mean < 10.0) {
+          _base = std::exp(-mean);
+        } else {
+          _logMean = std::log(mean);
+          _b = 0.931 + 2.53 * std::sqrt(mean);
+          _a = -0.059 + 0.02483 * _b;
+          _logInvAlpha = std::log(1.1239 + 1.1328 / (_b - 3.4));
+          _vr = 0.9277 - 3.6224 / (_b - 2.0);
+        }
+      }
+
+      /**
+       * Generate a random number
+       *
+       * @param s  Sponge to use for randomization
+       * @return the number generated
+       */
+      template <typename S>
+      std::size_t operator()(S &s) const {
+        return _mean < 10.0 ? inversion(s) : ptrs(s);
+      }
+
+    protected:
+      /**
+       * Generate a random number by sequential search
+       *
+       * Should the cumulative probability stall below the uniform drawn (due
+       * to rounding), the search is restarted.
+       *
+       * @param s  Sponge to use for randomization
+       * @return the number generated
+       */
+      template <typename S>
+      std::size_t inversion(S &s) const {
+        while (true) {
+          double u = Draupnir::Random::openReal(s);
+          double p = _base, f = _base;
+          std::size_t x = 0;
+          while (f < u) {
+            x++;
+            p *= _mean / static_cast<double>(x);
+            if (!(f < f + p)) {
+              break;
+            }
+            f += p;
+          }
+          if (!(f < u)) {
+            return x;
+          }
+        }
+      }
+
+      /**
+       * Generate a random number by transformed rejection with squeeze
+       *
+       * @param s  Sponge to use for randomization
+       * @return the number generated
+       */
+      template <typename S>
+      std::size_t ptrs(S &s) const {
+        while (true) {
+          double u = Draupnir::Random::openReal(s) - 0.5;
+          double v = Draupnir::Random::openReal(s);
+          double us = 0.5 - std::fabs(u);
+          double k = std::floor((2.0 * _a / us + _b) * u + _mean + 0.43);
+
+          if (0.07 <= us && v <= _vr) {
+            return static_cast<std::size_t>(k);
+          }
+          if (k < 0.0 || (us < 0.013 && us < v)) {
+            continue;
+          }
+          if (std::log(v) + _logInvAlpha - std::log(_a / (us * us) + _b) <= -_mean + k * _logMean - std::lgamma(k + 1.0)) {
+            return static_cast<std::size_t>(k);
+          }
+        }
+      }
+
+      /**
+       * Distribution's mean
+       *
+       */
+      double _mean;
+
+      /**
+       * Probability of 0 (inversion only)
+       *
+       */
+      double _base;
+
+      /**
+       * Hat parameters (PTRS only)
+       *
+       */
+      double _a, _b, _logInvAlpha, _vr;
+
+      /**
+       * Logarithm of the mean (PTRS only)
+       *
+       */
+      double _logMean;
+  };
+
+  /**
+   * Binomial generator holding the setup for a given number of trials and success probability
+   *
+   */
+  class BinomialGenerator {
+    public:
+      /**
+       * Perform the setup for the given parameters
+       *
+       * Success probabilities above 1/2 are handled by generating the number
+       * of failures instead.
+       *
+       * @param n  Number of trials
+       * @param p  Success probability of each trial
+       */
+      BinomialGenerator(std::size_t n, double p) noexcept : _n{n}, _m{0}, _p{std::max(0.0, std::min(p, 1.0 - p))}, _r{0.0}, _nr{0.0}, _npq{0.0}, _a{0.0}, _b{0.0}, _c{0.0}, _alpha{0.0}, _vr{0.0}, _urvr{0.0}, _h{0.0}, _base{0.0}, _flip{0.5 < p} {
+        double nn = static_cast<double>(n);
+        double q = 1.0 - _p;
+
+        _r = _p / q;
+        _nr = (nn + 1.0) * _r;
+        if (nn * _p < 10.0) {
+          _base = std::pow(q, nn);
+        } else {
+          _m = static_cast<std::size_t>(std::floor((nn + 1.0) * _p));
+          _npq = nn * _p * q;
+          double sq = std::sqrt(_npq);
+          _b = 1.15 + 2.53 * sq;
+          _a = -0.0873 + 0.0248 * _b + 0.01 * _p;
+          _c = nn * _p + 0.5;
+          _alpha = (2.83 + 5.1 / _b) * sq;
+          _vr = 0.92 - 4.2 / _b;
+          _urvr = 0.86 * _vr;
+          double m = static_cast<double>(_m);
+          _h = (m + 0.5) * std::log((m + 1.0) / (_r * (nn - m + 1.0))) + stirlingCorrection(_m) + stirlingCorrection(_n - _m);
+        }
+      }
+
+      /**
+       * Generate a random number
+       *
+       * @param s  Sponge to use for randomization
+       * @return the number generated
+       */
+      template <typename S>
+      std::size_t operator()(S &s) const {
+        std::size_t k = static_cast<double>(_n) * _p < 10.0 ? inversion(s) : btrd(s);
+        return _flip ? _n - k : k;
+      }
+
+    protected:
+      /**
+       * Generate a random number by sequential search
+       *
+       * Should the search overrun the number of trials (due to rounding), it
+       * is restarted.
+       *
+       * @param s  Sponge to use for randomization
+       * @return the number generated
+       */
+      template <typename S>
+      std::size_t inversion(S &s) const {
+        while (true) {
+          double u = Draupnir::Random::openReal(s);
+          double p = _base;
+          std::size_t x = 0;
+          while (p < u && x <= _n) {
+            u -= p;
+            x++;
+            p *= _nr / static_cast<double>(x) - _r;
+          }
+          if (x <= _n) {
+            return x;
+          }
+        }
+      }
+
+      /**
+       * Generate a random number by transformed rejection with decomposition
+       *
+       * @param s  Sponge to use for randomization
+       * @return the number generated
+       */
+      template <typename S>
+      std::size_t btrd(S &s) const {
+        double nn = static_cast<double>(_n);
+
+        while (true) {
+          double v = Draupnir::Random::openReal(s);
+          double u;
+
+          // decomposition: the central part can be accepted immediately
+          if (v <= _urvr) {
+            u = v / _vr - 0.43;
+            return static_cast<std::size_t>(std::floor((2.0 * _a / (0.5 - std::fabs(u)) + _b) * u + _c));
+          }
+          if (_vr <= v) {
+            u = Draupnir::Random::openReal(s) - 0.5;
+          } else {
+            u = v / _vr - 0.93;
+            u = (u < 0.0 ? -0.5 : 0.5) - u;
+            v = Draupnir::Random::openReal(s) * _vr;
+          }
+
+          double us = 0.5 - std::fabs(u);
+          double kk = std::floor((2.0 * _a / us + _b) * u + _c);
+          if (kk < 0.0 || nn < kk) {
+            continue;
+          }
+          std::size_t k = static_cast<std::size_t>(kk);
+          v *= _alpha / (_a / (us * us) + _b);
+          std::size_t km = k < _m ? _m - k : k - _m;
+
+          // close to the mode: evaluate f(k) / f(m) recursively
+          if (km <= 15) {
+            double f = 1.0;
+            for (std::size_t i = _m + 1; i <= k; i++) {
+              f *= _nr / static_cast<double>(i) - _r;
+            }
+            for (std::size_t i = k + 1; i <= _m; i++) {
+              v *= _nr / static_cast<double>(i) - _r;
+            }
+            if (v <= f) {
+              return k;
+            }
+            continue;
+          }
+
+          // squeeze
+          double dkm = static_cast<double>(km);
+          v = std::log(v);
+          double rho = (dkm / _npq) * (((dkm / 3.0 + 0.625) * dkm + 1.0 / 6.0) / _npq + 0.5);
+          double t = -dkm * dkm / (2.0 * _npq);
+          if (v < t - rho) {
+            return k;
+          }
+          if (t + rho < v) {
+            continue;
+          }
+
+          // final acceptance test
+          double nm = nn - static_cast<double>(_m) + 1.0;
+          double nk = nn - kk + 1.0;
+          if (v <= _h + (nn + 1.0) * std::log(nm / nk) + (kk + 0.5) * std::log(nk * _r / (kk + 1.0)) - stirlingCorrection(k) - stirlingCorrection(_n - k)) {
+            return k;
+          }
+        }
+      }
+
+      /**
+       * Number of trials
+       *
+       */
+      std::size_t _n;
+
+      /**
+       * Distribution's mode (BTRD only)
+       *
+       */
+      std::size_t _m;
+
+      /**
+       * Success probability (at most 1/2)
+       *
+       */
+      double _p;
+
+      /**
+       * Success to failure ratio, and the same multiplied by n + 1
+       *
+       */
+      double _r, _nr;
+
+      /**
+       * Variance (BTRD only)
+       *
+       */
+      double _npq;
+
+      /**
+       * Hat and decomposition parameters (BTRD only)
+       *
+       */
+      double _a, _b, _c, _alpha, _vr, _urvr, _h;
+
+      /**
+       * Probability of 0 (inversion only)
+       *
+       */
+      double _base;
+
+      /**
+       * Whether the number of failures is being generated instead
+       *
+       */
+      bool _flip;
+  };
+
+  /**
+   * Determine the probability with which the derangement algorithm closes a cycle
+   *
+   * This is (u - 1) D(u - 2) / D(u), D(u) being the number of derangements
+   * of size u; given that D(u) = (u - 1) (D(u - 1) + D(u - 2)), it equals
+   * D(u - 2) / (D(u - 1) + D(u - 2)), which is evaluated exactly for small
+   * u, and approximated by 1 / u (with an error below 1 / u!) otherwise.
+   *
+   * @param u  Number of elements yet to be deranged (at least 2)
+   * @return the probability of closing a cycle
    */
-  bool isDerangement(std::vector<std::size_t> const &x) {
-    for (std::size_t i = 0; i < x.size(); i++) {
-      if (x[i] == i) {
-        return false;
+  inline double derangementClosing(std::size_t u) noexcept {
+    if (20 < u) {
+      return 1.0 / static_cast<double>(u);
+    }
+    double d2 = 1.0, d1 = 0.0;
+    for (std::size_t k = 2; k < u; k++) {
+      double d = static_cast<double>(k - 1) * (d1 + d2);
+      d2 = d1;
+      d1 = d;
+    }
+    return d2 / (d1 + d2);
+  }
+
+  /**
+   * Number of swap targets drawn (and prefetched) ahead of the swaps proper when shuffling
+   *
+   */
+  constexpr std::size_t shuffleWindow = 32;
+
+  /**
+   * Largest number of bounded indices drawn out of a single 64-bit word when shuffling
+   *
+   */
+  constexpr std::size_t shuffleBatch = 6;
+
+  /**
+   * Hint the processor to bring the element pointed to by the given iterator into cache
+   *
+   * @param it  Iterator pointing to the element to prefetch
+   */
+  template <typename RandomIt>
+  inline typename std::enable_if<std::is_lvalue_reference<typename std::iterator_traits<RandomIt>::reference>::value>::type prefetch(RandomIt it) noexcept {
+    __builtin_prefetch(std::addressof(*it), 1);
+  }
+
+  /**
+   * Hint the processor to bring the element pointed to by the given iterator into cache - proxy references
+   *
+   * Iterators not yielding actual references cannot be prefetched through, so this is a no-op.
+   *
+   * @param it  Iterator pointing to the element to prefetch
+   */
+  template <typename RandomIt>
+  inline typename std::enable_if<!std::is_lvalue_reference<typename std::iterator_traits<RandomIt>::reference>::value>::type prefetch(RandomIt) noexcept {}
+
+  /**
+   * Draw a batch of bounded indices out of a single 64-bit word
+   *
+   * The i-th index drawn lies between 0 and bound - i - 1 inclusive; the
+   * indices are extracted with Lemire's multiply-shift method, each
+   * multiplication's lower half feeding the next, and the whole batch is
+   * rejected (and redrawn) when the final lower half falls below 2^64 modulo
+   * the bounds' product, as per Brackett-Rozinsky and Lemire; the common case
+   * thus requires no division at all.
+   *
+   * @param s  Sponge to use for randomization
+   * @param bound  Bound for the first index drawn
+   * @param count  Number of indices to draw
+   * @param product  Product of all the bounds involved (must fit in 64 bits)
+   * @param out  Pointer to the storage where to write the indices drawn
+   */
+  template <typename S>
+  void boundedBatch(S &s, std::uint64_t bound, std::size_t count, std::uint64_t product, std::size_t *out) {
+    std::uint64_t threshold = 0;
+    for (bool first = true; ; first = false) {
+      std::uint64_t low = rand<std::uint64_t>(s);
+      for (std::size_t i = 0; i < count; i++) {
+        unsigned __int128 full = static_cast<unsigned __int128>(low) * (bound - i);
+        out[i] = static_cast<std::size_t>(full >> 64);
+        low = static_cast<std::uint64_t>(full);
+      }
+      if (product <= low) {
+        return;
+      }
+      if (first) {
+        threshold = (0 - product) % product;
+      }
+      if (threshold <= low) {
+        return;
       }
     }
-    return true;
+  }
+
+  /**
+   * Draw the next window of Fisher--Yates swap targets, prefetching each
+   *
+   * The targets are drawn for bounds size, size - 1, ... down to 2, at most
+   * shuffleWindow of them, and as many to a 64-bit word as the bounds allow.
+   *
+   * @param s  Sponge to use for randomization
+   * @param first  Iterator pointing to the first element being shuffled
+   * @param size  Number of elements yet to shuffle
+   * @param out  Pointer to the storage where to write the targets drawn (at least shuffleWindow elements)
+   * @return the number of targets drawn
+   */
+  template <typename RandomIt, typename S>
+  std::size_t shuffleWindowFill(S &s, RandomIt first, std::size_t size, std::size_t *out) {
+    std::size_t drawn = 0;
+    while (drawn < shuffleWindow && 1 < size - drawn) {
+      std::uint64_t bound = size - drawn;
+      unsigned __int128 product = bound;
+      std::size_t count = 1;
+      while (count < shuffleBatch && drawn + count < shuffleWindow && 1 < bound - count) {
+        unsigned __int128 next = product * (bound - count);
+        if (0 != (next >> 64)) {
+          break;
+        }
+        product = next;
+        count++;
+      }
+
+      boundedBatch(s, bound, count, static_cast<std::uint64_t>(product), out + drawn);
+      for (std::size_t i = drawn; i < drawn + count; i++) {
+        prefetch(first + static_cast<std::ptrdiff_t>(out[i]));
+      }
+      drawn += count;
+    }
+    return drawn;
   }
 
 }
 
-namespace Draupnir {
+namespace Draupnir {
+
+  namespace Random {
+
+    /**
+     * Extract a random number between 0 and the given limit of the templated length from the given sponge
+     *
+     * @param s  Sponge to use for randomization
+     * @param high  Highest possible value to return
+     * @return a random number between 0 and the given limit fitting in the templated length
+     */
+    template <typename T, typename S>
+    T natural(S &s, T high) {
+      T result = rand<T>(s);
+
+      if (high != std::numeric_limits<T>::max()) {
+        T delta = static_cast<T>(high + 1);
+        T limit = static_cast<T>(std::numeric_limits<T>::max() - (std::numeric_limits<T>::max() % delta));
+        while (result >= limit) {
+          result = rand<T>(s);
+        }
+        result = result % delta;
+      }
+
+      return result;
+    }
+
+    /**
+     * Extract a random multi-limb number between 0 and the given limit from the given sponge
+     *
+     * @param s  Sponge to use for randomization
+     * @param high  Pointer to the highest possible value to return
+     * @param limbs  Number of limbs in both the limit and the output
+     * @param out  Pointer to the storage where to write the number generated
+     */
+    template <typename S>
+    void natural(S &s, std::uint64_t const *high, std::size_t limbs, std::uint64_t *out) {
+      natural(s, high, limbs, out, 1);
+    }
+
+    /**
+     * Extract a random multi-limb number between 0 and the given limit from the given sponge - type-erased
+     *
+     * This overload merely forwards to the sponge-type-templated one.
+     *
+     * @param s  Sponge to use for randomization
+     * @param high  Pointer to the highest possible value to return
+     * @param limbs  Number of limbs in both the limit and the output
+     * @param out  Pointer to the storage where to write the number generated
+     */
+    inline void natural(Draupnir::Sponge &s, std::uint64_t const *high, std::size_t limbs, std::uint64_t *out) {
+      natural<Draupnir::Sponge>(s, high, limbs, out, 1);
+    }
+
+    /**
+     * Extract the given number of random multi-limb numbers between 0 and the given limit from the given sponge
+     *
+     * Each attempt draws the top limb first (masked to the limit's bit
+     * length), and then every lower one, while tracking whether the digits
+     * drawn so far are still tied with the limit's: an attempt is abandoned
+     * as soon as a tied digit exceeds the limit's, and once untied, the
+     * remaining limbs are merely drawn.
+     *
+     * @param s  Sponge to use for randomization
+     * @param high  Pointer to the highest possible value to return
+     * @param limbs  Number of limbs in both the limit and each output number
+     * @param out  Pointer to the storage where to write the numbers generated (of at least count * limbs limbs)
+     * @param count  Number of numbers to generate
+     */
+    template <typename S>
+    void natural(S &s, std::uint64_t const *high, std::size_t limbs, std::uint64_t *out, std::size_t count) {
+      std::fill(out, out + count * limbs, 0);
+
+      std::size_t top = limbs;
+      while (0 < top && 0 == high[top - 1]) {
+        top--;
+      }
+      if (0 == top--) {
+        return;
+      }
+
+      std::size_t topBits = 0;
+      while (topBits < 64 && 0 != (high[top] >> topBits)) {
+        topBits++;
+      }
+      std::size_t topBytes = (topBits + 7) / 8;
+      std::uint64_t topMask = 64 == topBits ? ~std::uint64_t(0) : (std::uint64_t(1) << topBits) - 1;
+
+      for (std::uint64_t *number = out; number != out + count * limbs; number += limbs) {
+        bool done = false;
+        while (!done) {
+          number[top] = squeezeLimb(s, topBytes) & topMask;
+          bool tied = number[top] == high[top];
+          done = number[top] <= high[top];
+          for (std::size_t j = top; done && 0 < j--; ) {
+            number[j] = squeezeLimb(s, 8);
+            if (tied) {
+              tied = number[j] == high[j];
+              done = number[j] <= high[j];
+            }
+          }
+        }
+      }
+    }
+
+    /**
+     * Extract the given number of random multi-limb numbers between 0 and the given limit from the given sponge - type-erased
+     *
+     * This overload merely forwards to the sponge-type-templated one.
+     *
+     * @param s  Sponge to use for randomization
+     * @param high  Pointer to the highest possible value to return
+     * @param limbs  Number of limbs in both the limit and each output number
+     * @param out  Pointer to the storage where to write the numbers generated (of at least count * limbs limbs)
+     * @param count  Number of numbers to generate
+     */
+    inline void natural(Draupnir::Sponge &s, std::uint64_t const *high, std::size_t limbs, std::uint64_t *out, std::size_t count) {
+      natural<Draupnir::Sponge>(s, high, limbs, out, count);
+    }
+
+    /**
+     * Derive a substream from the given sponge
+     *
+     * The index is soaked in its decimal representation.
+     *
+     * @param s  Sponge to derive the substream from
+     * @param index  Substream index
+     * @return a pointer to the newly derived substream
+     */
+    template <typename S>
+    std::unique_ptr<S> substream(S const &s, std::size_t index) {
+      std::unique_ptr<S> result(s.clone());
+      result->soak(std::to_string(index));
+      return result;
+    }
+
+    /**
+     * Generate a random real value between 0 and 1
+     *
+     * @param s  Sponge to use for randomization
+     * @return the real number generated
+     */
+    template <typename S>
+    long double real(S &s) {
+      return static_cast<long double>(natural<std::uint64_t>(s)) / static_cast<long double>(std::numeric_limits<std::uint64_t>::max());
+    }
+
+    /**
+     * Generate a random real value between 0 and 1 - type-erased
+     *
+     * This overload merely forwards to the sponge-type-templated one.
+     *
+     * @param s  Sponge to use for randomization
+     * @return the real number generated
+     */
+    inline long double real(Draupnir::Sponge &s) {
+      return real<Draupnir::Sponge>(s);
+    }
+
+    /**
+     * Generate a random real value strictly between 0 and 1
+     *
+     * This function never yields either endpoint, so that its result can be
+     * safely fed to logarithms and divisions; it does so by taking the top 53
+     * bits of a random 64 bit number and placing the result at the center of
+     * the corresponding interval.
+     *
+     * @param s  Sponge to use for randomization
+     * @return the real number generated
+     */
+    template <typename S>
+    double openReal(S &s) {
+      return (static_cast<double>(rand<std::uint64_t>(s) >> 11) + 0.5) * 0x1.0p-53;
+    }
+
+    /**
+     * Generate a random real value strictly between 0 and 1 - type-erased
+     *
+     * This overload merely forwards to the sponge-type-templated one.
+     *
+     * @param s  Sponge to use for randomization
+     * @return the real number generated
+     */
+    inline double openReal(Draupnir::Sponge &s) {
+      return openReal<Draupnir::Sponge>(s);
+    }
+
+    /**
+     * Generate a random real value following the standard normal distribution
+     *
+     * This function uses the ziggurat method: the fast path (taken about 99%
+     * of the time) consumes a single 64 bit word and involves no
+     * transcendental function evaluation.
+     *
+     * The word's lowest 8 bits select a layer, and its top 53 bits yield a
+     * uniform value in [-1, 1) to scale the layer's width by; only if the
+     * result falls outside the layer's inner rectangle is the density
+     * evaluated (or the tail sampled, for the base layer).
+     *
+     * @param s  Sponge to use for randomization
+     * @return the real number generated
+     */
+    template <typename S>
+    double normal(S &s) {
+      while (true) {
+        std::uint64_t bits = rand<std::uint64_t>(s);
+        std::size_t i = bits & 0xff;
+        double u = static_cast<double>(bits >> 11) * 0x1.0p-52 - 1.0;
+        double x = u * zigguratNormalX[i];
+
+        if (std::fabs(x) < zigguratNormalX[i + 1]) {
+          return x;
+        }
+        if (0 == i) {
+          // sample the tail using Marsaglia's method
+          double a, b;
+          do {
+            a = std::log(openReal(s)) / zigguratNormalR;
+            b = std::log(openReal(s));
+          } while (-2.0 * b < a * a);
+          return u < 0.0 ? a - zigguratNormalR : zigguratNormalR - a;
+        }
+        if (zigguratNormalF[i + 1] + (zigguratNormalF[i] - zigguratNormalF[i + 1]) * openReal(s) < std::exp(-0.5 * x * x)) {
+          return x;
+        }
+      }
+    }
+
+    /**
+     * Generate a random real value following the standard normal distribution - type-erased
+     *
+     * This overload merely forwards to the sponge-type-templated one.
+     *
+     * @param s  Sponge to use for randomization
+     * @return the real number generated
+     */
+    inline double normal(Draupnir::Sponge &s) {
+      return normal<Draupnir::Sponge>(s);
+    }
+
+    /**
+     * Fill the given range with random real values following the given normal distribution
+     *
+     * @param s  Sponge to use for randomization
+     * @param first  Iterator pointing to the first element to fill
+     * @param last  Iterator pointing past the last element to fill
+     * @param mean  Distribution's mean
+     * @param stddev  Distribution's standard deviation
+     */
+    template <typename ForwardIt, typename S>
+    void normal(S &s, ForwardIt first, ForwardIt last, double mean, double stddev) {
+      for (; first != last; ++first) {
+        *first = mean + stddev * normal(s);
+      }
+    }
+
+    /**
+     * Generate a random real value following the standard exponential distribution
+     *
+     * This function uses the ziggurat method: the fast path (taken about 98%
+     * of the time) consumes a single 64 bit word and involves no
+     * transcendental function evaluation.
+     *
+     * The word's lowest 8 bits select a layer, and its top 53 bits yield a
+     * uniform value in [0, 1) to scale the layer's width by; only if the
+     * result falls outside the layer's inner rectangle is the density
+     * evaluated (or the tail sampled, for the base layer).
+     *
+     * @param s  Sponge to use for randomization
+     * @return the real number generated
+     */
+    template <typename S>
+    double exponential(S &s) {
+      while (true) {
+        std::uint64_t bits = rand<std::uint64_t>(s);
+        std::size_t i = bits & 0xff;
+        double x = static_cast<double>(bits >> 11) * 0x1.0p-53 * zigguratExponentialX[i];
+
+        if (x < zigguratExponentialX[i + 1]) {
+          return x;
+        }
+        if (0 == i) {
+          // the exponential distribution is memoryless: the tail is merely shifted
+          return zigguratExponentialR - std::log(openReal(s));
+        }
+        if (zigguratExponentialF[i + 1] + (zigguratExponentialF[i] - zigguratExponentialF[i + 1]) * openReal(s) < std::exp(-x)) {
+          return x;
+        }
+      }
+    }
+
+    /**
+     * Generate a random real value following the standard exponential distribution - type-erased
+     *
+     * This overload merely forwards to the sponge-type-templated one.
+     *
+     * @param s  Sponge to use for randomization
+     * @return the real number generated
+     */
+    inline double exponential(Draupnir::Sponge &s) {
+      return exponential<Draupnir::Sponge>(s);
+    }
+
+    /**
+     * Fill the given range with random real values following the given exponential distribution
+     *
+     * @param s  Sponge to use for randomization
+     * @param first  Iterator pointing to the first element to fill
+     * @param last  Iterator pointing past the last element to fill
+     * @param rate  Distribution's rate (ie. the inverse of its mean)
+     */
+    template <typename ForwardIt, typename S>
+    void exponential(S &s, ForwardIt first, ForwardIt last, double rate) {
+      double scale = 1.0 / rate;
+      for (; first != last; ++first) {
+        *first = scale * exponential(s);
+      }
+    }
+
+    /**
+     * Generate a random real value following the gamma distribution with the given shape and unit scale
+     *
+     * This function uses Marsaglia and Tsang's method on top of normal();
+     * shapes below 1 are handled by boosting the shape by 1 and scaling the
+     * result by u^(1 / shape).
+     *
+     * @param s  Sponge to use for randomization
+     * @param shape  Distribution's shape (must be positive)
+     * @return the real number generated
+     */
+    template <typename S>
+    double gamma(S &s, double shape) {
+      if (shape < 1.0) {
+        return gamma(s, shape + 1.0) * std::pow(openReal(s), 1.0 / shape);
+      }
+
+      double d = shape - 1.0 / 3.0;
+      double c = 1.0 / std::sqrt(9.0 * d);
+      while (true) {
+        double x, v;
+        do {
+          x = normal(s);
+          v = 1.0 + c * x;
+        } while (v <= 0.0);
+        v = v * v * v;
+
+        double u = openReal(s);
+        double xx = x * x;
+        if (u < 1.0 - 0.0331 * xx * xx || std::log(u) < 0.5 * xx + d * (1.0 - v + std::log(v))) {
+          return d * v;
+        }
+      }
+    }
+
+    /**
+     * Generate a random real value following the gamma distribution with the given shape and unit scale - type-erased
+     *
+     * This overload merely forwards to the sponge-type-templated one.
+     *
+     * @param s  Sponge to use for randomization
+     * @param shape  Distribution's shape (must be positive)
+     * @return the real number generated
+     */
+    inline double gamma(Draupnir::Sponge &s, double shape) {
+      return gamma<Draupnir::Sponge>(s, shape);
+    }
+
+    /**
+     * Fill the given range with random real values following the given gamma distribution
+     *
+     * @param s  Sponge to use for randomization
+     * @param first  Iterator pointing to the first element to fill
+     * @param last  Iterator pointing past the last element to fill
+     * @param shape  Distribution's shape (must be positive)
+     * @param scale  Distribution's scale
+     */
+    template <typename ForwardIt, typename S>
+    void gamma(S &s, ForwardIt first, ForwardIt last, double shape, double scale) {
+      for (; first != last; ++first) {
+        *first = scale * gamma(s, shape);
+      }
+    }
+
+    /**
+     * Generate a random natural number following the Poisson distribution with the given mean
+     *
+     * This function uses Hörmann's PTRS (ie. transformed rejection with
+     * squeeze) for means of 10 and above, and inversion by sequential search
+     * (from a single uniform draw) below that; both take constant expected
+     * time.
+     *
+     * @param s  Sponge to use for randomization
+     * @param mean  Distribution's mean (must be non-negative)
+     * @return the natural number generated
+     */
+    template <typename S>
+    std::size_t poisson(S &s, double mean) {
+      return PoissonGenerator(mean)(s);
+    }
+
+    /**
+     * Generate a random natural number following the Poisson distribution with the given mean - type-erased
+     *
+     * This overload merely forwards to the sponge-type-templated one.
+     *
+     * @param s  Sponge to use for randomization
+     * @param mean  Distribution's mean (must be non-negative)
+     * @return the natural number generated
+     */
+    inline std::size_t poisson(Draupnir::Sponge &s, double mean) {
+      return poisson<Draupnir::Sponge>(s, mean);
+    }
+
+    /**
+     * Fill the given range with random natural numbers following the Poisson distribution with the given mean
+     *
+     * The distribution's setup is performed only once for the whole range.
+     *
+     * @param s  Sponge to use for randomization
+     * @param first  Iterator pointing to the first element to fill
+     * @param last  Iterator pointing past the last element to fill
+     * @param mean  Distribution's mean (must be non-negative)
+     */
+    template <typename ForwardIt, typename S>
+    void poisson(S &s, ForwardIt first, ForwardIt last, double mean) {
+      PoissonGenerator generator(mean);
+      for (; first != last; ++first) {
+        *first = generator(s);
+      }
+    }
+
+    /**
+     * Generate a random natural number following the binomial distribution with the given parameters
+     *
+     * This function uses Hörmann's BTRD (ie. transformed rejection with
+     * decomposition) whenever n * min(p, 1 - p) is 10 or above, and inversion
+     * by sequential search (from a single uniform draw) below that; both take
+     * constant expected time.
+     *
+     * @param s  Sponge to use for randomization
+     * @param n  Number of trials
+     * @param p  Success probability of each trial
+     * @return the natural number generated
+     */
+    template <typename S>
+    std::size_t binomial(S &s, std::size_t n, double p) {
+      return BinomialGenerator(n, p)(s);
+    }
+
+    /**
+     * Generate a random natural number following the binomial distribution with the given parameters - type-erased
+     *
+     * This overload merely forwards to the sponge-type-templated one.
+     *
+     * @param s  Sponge to use for randomization
+     * @param n  Number of trials
+     * @param p  Success probability of each trial
+     * @return the natural number generated
+     */
+    inline std::size_t binomial(Draupnir::Sponge &s, std::size_t n, double p) {
+      return binomial<Draupnir::Sponge>(s, n, p);
+    }
+
+    /**
+     * Fill the given range with random natural numbers following the binomial distribution with the given parameters
+     *
+     * The distribution's setup is performed only once for the whole range.
+     *
+     * @param s  Sponge to use for randomization
+     * @param first  Iterator pointing to the first element to fill
+     * @param last  Iterator pointing past the last element to fill
+     * @param n  Number of trials
+     * @param p  Success probability of each trial
+     */
+    template <typename ForwardIt, typename S>
+    void binomial(S &s, ForwardIt first, ForwardIt last, std::size_t n, double p) {
+      BinomialGenerator generator(n, p);
+      for (; first != last; ++first) {
+        *first = generator(s);
+      }
+    }
+
+    /**
+     * Generate a random natural number following the geometric distribution with the given success probability
+     *
+     * The number generated is the number of failures before the first
+     * success, obtained by inversion from a single uniform draw (ie.
+     * floor(log(u) / log(1 - p))).
+     *
+     * @param s  Sponge to use for randomization
+     * @param p  Success probability of each trial
+     * @return the natural number generated (saturated to the largest std::size_t value)
+     */
+    template <typename S>
+    std::size_t geometric(S &s, double p) {
+      if (!(p < 1.0)) {
+        return 0;
+      }
+      double x = std::floor(std::log(openReal(s)) / std::log1p(-p));
+      if (x < static_cast<double>(std::numeric_limits<std::size_t>::max())) {
+        return static_cast<std::size_t>(x);
+      }
+      return std::numeric_limits<std::size_t>::max();
+    }
+
+    /**
+     * Generate a random natural number following the geometric distribution with the given success probability - type-erased
+     *
+     * This overload merely forwards to the sponge-type-templated one.
+     *
+     * @param s  Sponge to use for randomization
+     * @param p  Success probability of each trial
+     * @return the natural number generated (saturated to the largest std::size_t value)
+     */
+    inline std::size_t geometric(Draupnir::Sponge &s, double p) {
+      return geometric<Draupnir::Sponge>(s, p);
+    }
+
+    /**
+     * Fill the given range with random natural numbers following the geometric distribution with the given success probability
+     *
+     * @param s  Sponge to use for randomization
+     * @param first  Iterator pointing to the first element to fill
+     * @param last  Iterator pointing past the last element to fill
+     * @param p  Success probability of each trial
+     */
+    template <typename ForwardIt, typename S>
+    void geometric(S &s, ForwardIt first, ForwardIt last, double p) {
+      for (; first != last; ++first) {
+        *first = geometric(s, p);
+      }
+    }
+
+    /**
+     * Generate a random vector of counts following the multinomial distribution with the given parameters
+     *
+     * This function draws each count from a binomial distribution over the
+     * trials remaining, with the category's weight relative to the weights
+     * remaining as success probability, so that it takes constant expected
+     * time per category.
+     *
+     * @param s  Sponge to use for randomization
+     * @param n  Number of trials
+     * @param first  Iterator pointing to the first category's weight (weights need not be normalized)
+     * @param last  Iterator pointing past the last category's weight
+     * @param out  Iterator to write the counts to (one per category)
+     * @return the iterator pointing past the last count written
+     */
+    template <typename ForwardIt, typename OutputIt, typename S>
+    OutputIt multinomial(S &s, std::size_t n, ForwardIt first, ForwardIt last, OutputIt out) {
+      double total = 0.0;
+      for (ForwardIt it = first; it != last; ++it) {
+        total += static_cast<double>(*it);
+      }
+
+      for (; first != last; ++first, ++out) {
+        double w = static_cast<double>(*first);
+        std::size_t k = 0;
+        if (0 < n && 0.0 < w) {
+          k = binomial(s, n, w < total ? w / total : 1.0);
+        }
+        *out = k;
+        n -= k;
+        total -= w;
+      }
+
+      return out;
+    }
+
+    /**
+     * Fill the given range of words with independent random bits, each set with the given probability
+     *
+     * In the dense case, lanes whose uniform expansion is still undecided
+     * compare their next digit against p's: a 0 against a 1 decides the bit
+     * set, a 1 against a 0 decides it unset; once p's expansion is exhausted
+     * (at most 53 digits, p being a double), the lanes still undecided are
+     * left unset, so that the probability realized is exactly p.
+     *
+     * In the sparse case, the range is cleared (or filled, for p above 1 -
+     * 1/16) and the gaps between exceptional bits are drawn from the
+     * geometric distribution.
+     *
+     * @param s  Sponge to use for randomization
+     * @param p  Probability of each bit being set
+     * @param first  Iterator pointing to the first word to fill
+     * @param last  Iterator pointing past the last word to fill
+     */
+    template <typename RandomIt, typename S>
+    void bernoulliBits(S &s, double p, RandomIt first, RandomIt last) {
+      constexpr double sparse = 1.0 / 16.0;
+
+      if (!(0.0 < p) || !(p < 1.0) || p < sparse || 1.0 - sparse < p) {
+        bool flip = 0.5 < p;
+        double q = flip ? 1.0 - p : p;
+        std::fill(first, last, flip ? ~std::uint64_t(0) : std::uint64_t(0));
+        if (!(0.0 < q)) {
+          return;
+        }
+
+        std::size_t bits = 64 * static_cast<std::size_t>(last - first);
+        for (std::size_t k = geometric(s, q); k < bits; ) {
+          first[static_cast<std::ptrdiff_t>(k / 64)] ^= std::uint64_t(1) << (k % 64);
+          std::size_t gap = geometric(s, q);
+          if (bits - k - 1 <= gap) {
+            break;
+          }
+          k += 1 + gap;
+        }
+        return;
+      }
+
+      for (; first != last; ++first) {
+        std::uint64_t result = 0, undecided = ~std::uint64_t(0);
+        for (double x = p; 0 != undecided && 0.0 < x; ) {
+          std::uint64_t u = rand<std::uint64_t>(s);
+          x *= 2.0;
+          if (1.0 <= x) {
+            x -= 1.0;
+            result |= undecided & ~u;
+            undecided &= u;
+          } else {
+            undecided &= ~u;
+          }
+        }
+        *first = result;
+      }
+    }
+
+    /**
+     * Generate a random permutation of the given size
+     *
+     * This function generates a random permutation of the given size using the
+     * Fisher--Yates shuffling algorithm; the permutation's elements will be the
+     * numbers between 0 and size - 1 inclusive.
+     *
+     * @param s  Sponge to use for randomization
+     * @param size  Permutation size
+     * @return a std::vector containing the generated permutation
+     */
+    template <typename S>
+    std::vector<std::size_t> permutation(S &s, std::size_t size) {
+      std::vector<std::size_t> result(size);
+      permutation(s, result.begin(), result.end());
+      return result;
+    }
+
+    /**
+     * Generate a random permutation of the given size - type-erased
+     *
+     * This overload merely forwards to the sponge-type-templated one.
+     *
+     * @param s  Sponge to use for randomization
+     * @param size  Permutation size
+     * @return a std::vector containing the generated permutation
+     */
+    inline std::vector<std::size_t> permutation(Draupnir::Sponge &s, std::size_t size) {
+      return permutation<Draupnir::Sponge>(s, size);
+    }
+
+    /**
+     * Generate a random permutation into the given range
+     *
+     * This function generates a random permutation of the numbers between 0
+     * and n - 1 inclusive (n being the range's length) using the "inside-out"
+     * Fisher--Yates shuffling algorithm; no allocation is performed.
+     *
+     * @param s  Sponge to use for randomization
+     * @param first  Iterator pointing to the first element to fill
+     * @param last  Iterator pointing past the last element to fill
+     */
+    template <typename RandomIt, typename S>
+    void permutation(S &s, RandomIt first, RandomIt last) {
+      std::size_t i = 0;
+      for (RandomIt it = first; it != last; ++it, i++) {
+        RandomIt jt = first + static_cast<std::ptrdiff_t>(natural<std::size_t>(s, i));
+        if (jt != it) {
+          *it = *jt;
+        }
+        *jt = i;
+      }
+    }
+
+    /**
+     * Generate a random cyclic permutation of the given size
+     *
+     * This function generates a random permutation of the given size using the
+     * Sattolo shuffling algorithm; the permutation's elements will be the
+     * numbers between 0 and size - 1 inclusive.
+     *
+     * @param s  Sponge to use for randomization
+     * @param size  Permutation size
+     * @return a std::vector containing the generated permutation
+     */
+    template <typename S>
+    std::vector<std::size_t> cycle(S &s, std::size_t size) {
+      std::vector<std::size_t> result(size);
+      cycle(s, result.begin(), result.end());
+      return result;
+    }
+
+    /**
+     * Generate a random cyclic permutation of the given size - type-erased
+     *
+     * This overload merely forwards to the sponge-type-templated one.
+     *
+     * @param s  Sponge to use for randomization
+     * @param size  Permutation size
+     * @return a std::vector containing the generated permutation
+     */
+    inline std::vector<std::size_t> cycle(Draupnir::Sponge &s, std::size_t size) {
+      return cycle<Draupnir::Sponge>(s, size);
+    }
 
-  namespace Random {
+    /**
+     * Generate a random cyclic permutation into the given range
+     *
+     * This function generates a random cyclic permutation of the numbers
+     * between 0 and n - 1 inclusive (n being the range's length) using the
+     * "inside-out" Sattolo shuffling algorithm; no allocation is performed.
+     *
+     * @param s  Sponge to use for randomization
+     * @param first  Iterator pointing to the first element to fill
+     * @param last  Iterator pointing past the last element to fill
+     */
+    template <typename RandomIt, typename S>
+    void cycle(S &s, RandomIt first, RandomIt last) {
+      if (first == last) {
+        return;
+      }
+      *first = 0;
+      std::size_t i = 1;
+      for (RandomIt it = first + 1; it != last; ++it, i++) {
+        RandomIt jt = first + static_cast<std::ptrdiff_t>(natural<std::size_t>(s, i - 1));
+        *it = *jt;
+        *jt = i;
+      }
+    }
 
     /**
-     * Extract a random number between 0 and the given limit of the templated length from the given sponge
+     * Shuffle the given range in place
+     *
+     * This function shuffles the given range using the Fisher--Yates
+     * shuffling algorithm, drawing bounded swap targets in batches (several
+     * of them out of a single 64-bit word whenever the bounds allow) a
+     * window ahead of the swaps proper, and prefetching each target as it is
+     * drawn, so that the memory latency of one window's swaps overlaps with
+     * the next one's.
      *
      * @param s  Sponge to use for randomization
-     * @param high  Highest possible value to return
-     * @return a random number between 0 and the given limit fitting in the templated length
+     * @param first  Iterator pointing to the first element to shuffle
+     * @param last  Iterator pointing past the last element to shuffle
      */
-    template <typename T>
-    T natural(Draupnir::Sponge &s, T high) {
-      T result = rand<T>(s);
+    template <typename RandomIt, typename S>
+    void shuffle(S &s, RandomIt first, RandomIt last) {
+      std::size_t size = static_cast<std::size_t>(std::distance(first, last));
+      std::size_t targets[2][shuffleWindow];
 
-      if (high != std::numeric_limits<T>::max()) {
-        T delta = static_cast<T>(high + 1);
-        T limit = static_cast<T>(std::numeric_limits<T>::max() - (std::numeric_limits<T>::max() % delta));
-        while (result >= limit) {
-          result = rand<T>(s);
+      std::size_t current = 0;
+      std::size_t pending = shuffleWindowFill(s, first, size, targets[current]);
+      while (0 < pending) {
+        std::size_t next = shuffleWindowFill(s, first, size - pending, targets[current ^ 1]);
+        for (std::size_t i = 0; i < pending; i++, size--) {
+          std::iter_swap(first + static_cast<std::ptrdiff_t>(size - 1), first + static_cast<std::ptrdiff_t>(targets[current][i]));
         }
-        result = result % delta;
+        current ^= 1;
+        pending = next;
       }
+    }
 
+    /**
+     * Generate a random derangement of the given size
+     *
+     * This function generates a random derangement of the given size directly,
+     * using Martínez, Panholzer and Prodinger's algorithm; the derangement's
+     * elements will be the numbers between 0 and size - 1 inclusive.
+     *
+     * @param s  Sponge to use for randomization
+     * @param size  Permutation size (must not be 1)
+     * @return a std::vector containing the generated permutation
+     * @throws std::domain_error in case size is 1
+     */
+    template <typename S>
+    std::vector<std::size_t> derangement(S &s, std::size_t size) {
+      std::vector<std::size_t> result(size);
+      std::vector<std::size_t> scratch(derangementScratchSize(size));
+      derangement(s, result.begin(), result.end(), scratch.data());
       return result;
     }
 
     /**
-     * Generate a random real value between 0 and 1
+     * Generate a random derangement of the given size - type-erased
+     *
+     * This overload merely forwards to the sponge-type-templated one.
      *
      * @param s  Sponge to use for randomization
-     * @return the real number generated
+     * @param size  Permutation size (must not be 1)
+     * @return a std::vector containing the generated permutation
+     * @throws std::domain_error in case size is 1
      */
-    long double real(Draupnir::Sponge &s) {
-      return static_cast<long double>(natural<std::uint64_t>(s)) / static_cast<long double>(std::numeric_limits<std::uint64_t>::max());
+    inline std::vector<std::size_t> derangement(Draupnir::Sponge &s, std::size_t size) {
+      return derangement<Draupnir::Sponge>(s, size);
     }
 
     /**
-     * Generate a random permutation of the given size
+     * Determine the scratch size needed for a derangement of the given size
      *
-     * This function generates a random permutation of the given size using the
-     * Fisher--Yates shuffling algorithm; the permutation's elements will be the
-     * numbers between 0 and size - 1 inclusive.
+     * @param size  Permutation size
+     * @return the number of std::size_t elements of scratch space needed
+     */
+    inline std::size_t derangementScratchSize(std::size_t size) noexcept {
+      return (size + std::numeric_limits<std::size_t>::digits - 1) / std::numeric_limits<std::size_t>::digits;
+    }
+
+    /**
+     * Generate a random derangement into the given range
+     *
+     * The scratch space holds a bitmap marking the positions already closed
+     * into a cycle. Positions are visited from last to first: each unmarked
+     * one is swapped with a random unmarked position before it, and the
+     * latter is marked (thus closing a cycle) with probability
+     * (u - 1) D(u - 2) / D(u), u being the number of unmarked positions left.
      *
      * @param s  Sponge to use for randomization
-     * @param size  Permutation size
-     * @return a std::vector containing the generated permutation
+     * @param first  Iterator pointing to the first element to fill
+     * @param last  Iterator pointing past the last element to fill (the range's length must not be 1)
+     * @param scratch  Scratch space (of at least derangementScratchSize(last - first) elements)
+     * @throws std::domain_error in case the range's length is 1
      */
-    std::vector<std::size_t> permutation(Draupnir::Sponge &s, std::size_t size) {
-      std::vector<std::size_t> result;
-      result.reserve(size);
-      for (std::size_t i = 0; i < size; i++) {
-        std::size_t j = natural<std::size_t>(s, i);
-        if (j != i) {
-          result[i] = result[j];
+    template <typename RandomIt, typename S>
+    void derangement(S &s, RandomIt first, RandomIt last, std::size_t *scratch) {
+      constexpr std::size_t digits = std::numeric_limits<std::size_t>::digits;
+      std::size_t n = static_cast<std::size_t>(last - first);
+      if (1 == n) {
+        throw std::domain_error("No derangement of size 1");
+      }
+
+      std::fill(scratch, scratch + derangementScratchSize(n), 0);
+      auto marked = [scratch](std::size_t k) {
+        return 0 != (scratch[k / digits] & (std::size_t(1) << (k % digits)));
+      };
+      std::size_t k = 0;
+      for (RandomIt it = first; it != last; ++it, k++) {
+        *it = k;
+      }
+
+      for (std::size_t i = n, u = n; 2 <= u; i--) {
+        if (!marked(i - 1)) {
+          std::size_t j;
+          do {
+            j = natural<std::size_t>(s, i - 2);
+          } while (marked(j));
+          std::iter_swap(first + static_cast<std::ptrdiff_t>(i - 1), first + static_cast<std::ptrdiff_t>(j));
+          if (openReal(s) < derangementClosing(u)) {
+            scratch[j / digits] |= std::size_t(1) << (j % digits);
+            u--;
+          }
+          u--;
         }
-        result[j] = i;
       }
+    }
+
+    /**
+     * Generate a uniform sampling with replacement (ie. simply a vector of random naturals)
+     *
+     * @param s  Sponge to use for randomization
+     * @param total  Total number to sample from (must be positive)
+     * @param size  Sample size to generate
+     * @return a vector holding the sample
+     * @throws std::domain_error in case total is 0 and a non-empty sample is requested
+     */
+    template <typename S>
+    std::vector<std::size_t> uniformSampleWithReplacement(S &s, std::size_t total, std::size_t size) {
+      std::vector<std::size_t> result(size);
+      uniformSampleWithReplacement(s, total, result.begin(), result.end());
       return result;
     }
 
     /**
-     * Generate a random cyclic permutation of the given size
+     * Generate a uniform sampling with replacement (ie. simply a vector of random naturals) - type-erased
      *
-     * This function generates a random permutation of the given size using the
-     * Sattolo shuffling algorithm; the permutation's elements will be the
-     * numbers between 0 and size - 1 inclusive.
+     * This overload merely forwards to the sponge-type-templated one.
      *
      * @param s  Sponge to use for randomization
-     * @param size  Permutation size
-     * @return a std::vector containing the generated permutation
+     * @param total  Total number to sample from (must be positive)
+     * @param size  Sample size to generate
+     * @return a vector holding the sample
+     * @throws std::domain_error in case total is 0 and a non-empty sample is requested
      */
-    std::vector<std::size_t> cycle(Draupnir::Sponge &s, std::size_t size) {
-      std::vector<std::size_t> result;
-      result.reserve(size);
-      result[0] = 0;
-      for (std::size_t i = 1; i < size; i++) {
-        std::size_t j = natural<std::size_t>(s, i - 1);
-        if (j != i) {
-          result[i] = result[j];
-        }
-        result[j] = i;
+    inline std::vector<std::size_t> uniformSampleWithReplacement(Draupnir::Sponge &s, std::size_t total, std::size_t size) {
+      return uniformSampleWithReplacement<Draupnir::Sponge>(s, total, size);
+    }
+
+    /**
+     * Generate a uniform sampling with replacement into the given range
+     *
+     * @param s  Sponge to use for randomization
+     * @param total  Total number to sample from (must be positive)
+     * @param first  Iterator pointing to the first element to fill
+     * @param last  Iterator pointing past the last element to fill
+     * @throws std::domain_error in case total is 0 and a non-empty sample is requested
+     */
+    template <typename ForwardIt, typename S>
+    void uniformSampleWithReplacement(S &s, std::size_t total, ForwardIt first, ForwardIt last) {
+      if (0 == total && first != last) {
+        throw std::domain_error("Empty range");
+      }
+      for (; first != last; ++first) {
+        *first = natural<std::size_t>(s, total - 1);
       }
-      return result;
     }
 
     /**
-     * Generate a random derangement of the given size
+     * Determine the scratch size needed for a sampling without replacement of the given size
      *
-     * This function generates a random permutation of the given size using the
-     * Fisher--Yates shuffling algorithm and applying rejection to the result;
-     * the derangement's elements will be the numbers between 0 and size - 1
-     * inclusive.
+     * @param size  Sample size to generate
+     * @return the number of std::size_t elements of scratch space needed
+     */
+    inline std::size_t sampleScratchSize(std::size_t size) noexcept {
+      return IndexSet::capacityFor(size);
+    }
+
+    /**
+     * Generate a uniform sampling without replacement
+     *
+     * This function dispatches on the sample's density: sparse samples are
+     * generated using Floyd's algorithm, while dense ones are generated using
+     * reservoir sampling.
      *
      * @param s  Sponge to use for randomization
-     * @param size  Permutation size
-     * @return a std::vector containing the generated permutation
+     * @param total  Total number to sample from
+     * @param size  Sample size to generate (clamped to total)
+     * @return a vector holding the sample
      */
-    std::vector<std::size_t> derangement(Draupnir::Sponge &s, std::size_t size) {
-      std::vector<std::size_t> result = permutation(s, size);
-      while (!isDerangement(result)) {
-        result = permutation(s, size);
+    template <typename S>
+    std::vector<std::size_t> uniformSampleWithoutReplacement(S &s, std::size_t total, std::size_t size) {
+      if (size < total / 4) {
+        return floydSampleWithoutReplacement(s, total, size);
       }
-      return result;
+      return reservoirSampleWithoutReplacement(s, total, size);
     }
 
     /**
-     * Generate a uniform sampling with replacement (ie. simply a vector of random naturals)
+     * Generate a uniform sampling without replacement - type-erased
+     *
+     * This overload merely forwards to the sponge-type-templated one.
      *
      * @param s  Sponge to use for randomization
      * @param total  Total number to sample from
-     * @param size  Sample size to generate
+     * @param size  Sample size to generate (clamped to total)
      * @return a vector holding the sample
      */
-    std::vector<std::size_t> uniformSampleWithReplacement(Draupnir::Sponge &s, std::size_t total, std::size_t size) {
-      std::vector<std::size_t> result;
-      for (std::size_t i = 0; i < size; i++) {
-        result[i] = natural<std::size_t>(s, total);
+    inline std::vector<std::size_t> uniformSampleWithoutReplacement(Draupnir::Sponge &s, std::size_t total, std::size_t size) {
+      return uniformSampleWithoutReplacement<Draupnir::Sponge>(s, total, size);
+    }
+
+    /**
+     * Generate a uniform sampling without replacement into the given range
+     *
+     * This function dispatches on the sample's density just as the vector
+     * returning one does; no allocation is performed.
+     *
+     * @param s  Sponge to use for randomization
+     * @param total  Total number to sample from
+     * @param first  Iterator pointing to the first element to fill
+     * @param last  Iterator pointing past the last element to fill (the sample size is clamped to total)
+     * @param scratch  Scratch space (of at least sampleScratchSize(last - first) elements)
+     * @return an iterator pointing past the last element written
+     */
+    template <typename RandomIt, typename S>
+    RandomIt uniformSampleWithoutReplacement(S &s, std::size_t total, RandomIt first, RandomIt last, std::size_t *scratch) {
+      if (static_cast<std::size_t>(last - first) < total / 4) {
+        return floydSampleWithoutReplacement(s, total, first, last, scratch);
       }
-      return result;
+      return reservoirSampleWithoutReplacement(s, total, first, last);
     }
 
     /**
      * Generate a uniform sampling without replacement using reservoir sampling
      *
+     * This function takes O(total) time and random draws.
+     *
      * @param s  Sponge to use for randomization
      * @param total  Total number to sample from
-     * @param size  Sample size to generate
+     * @param size  Sample size to generate (clamped to total)
      * @return a vector holding the sample
      */
-    std::vector<std::size_t> uniformSampleWithoutReplacement(Draupnir::Sponge &s, std::size_t total, std::size_t size) {
-      std::vector<std::size_t> result;
-      for (std::size_t i = 0; i < size; i++) {
-        result[i] = i;
+    template <typename S>
+    std::vector<std::size_t> reservoirSampleWithoutReplacement(S &s, std::size_t total, std::size_t size) {
+      std::vector<std::size_t> result(std::min(size, total));
+      reservoirSampleWithoutReplacement(s, total, result.begin(), result.end());
+      return result;
+    }
+
+    /**
+     * Generate a uniform sampling without replacement using reservoir sampling - type-erased
+     *
+     * This overload merely forwards to the sponge-type-templated one.
+     *
+     * @param s  Sponge to use for randomization
+     * @param total  Total number to sample from
+     * @param size  Sample size to generate (clamped to total)
+     * @return a vector holding the sample
+     */
+    inline std::vector<std::size_t> reservoirSampleWithoutReplacement(Draupnir::Sponge &s, std::size_t total, std::size_t size) {
+      return reservoirSampleWithoutReplacement<Draupnir::Sponge>(s, total, size);
+    }
+
+    /**
+     * Generate a uniform sampling without replacement into the given range using reservoir sampling
+     *
+     * @param s  Sponge to use for randomization
+     * @param total  Total number to sample from
+     * @param first  Iterator pointing to the first element to fill
+     * @param last  Iterator pointing past the last element to fill (the sample size is clamped to total)
+     * @return an iterator pointing past the last element written
+     */
+    template <typename RandomIt, typename S>
+    RandomIt reservoirSampleWithoutReplacement(S &s, std::size_t total, RandomIt first, RandomIt last) {
+      std::size_t size = std::min(static_cast<std::size_t>(last - first), total);
+      last = first + static_cast<std::ptrdiff_t>(size);
+      std::size_t i = 0;
+      for (RandomIt it = first; it != last; ++it, i++) {
+        *it = i;
       }
-      for (std::size_t i = size; i < total; i++) {
+      for (; i < total; i++) {
         std::size_t j = natural<std::size_t>(s, i);
         if (j < size) {
-          result[j] = i;
+          first[static_cast<std::ptrdiff_t>(j)] = i;
         }
       }
+      return last;
+    }
+
+    /**
+     * Generate a uniform sampling without replacement using Floyd's algorithm
+     *
+     * This function takes O(size) expected time and exactly size random
+     * draws, keeping the elements chosen so far in an open-addressing hash set.
+     *
+     * @param s  Sponge to use for randomization
+     * @param total  Total number to sample from
+     * @param size  Sample size to generate (clamped to total)
+     * @return a vector holding the sample
+     */
+    template <typename S>
+    std::vector<std::size_t> floydSampleWithoutReplacement(S &s, std::size_t total, std::size_t size) {
+      std::vector<std::size_t> result(std::min(size, total));
+      std::vector<std::size_t> table(sampleScratchSize(result.size()));
+      floydSampleWithoutReplacement(s, total, result.begin(), result.end(), table.data());
       return result;
     }
 
+    /**
+     * Generate a uniform sampling without replacement using Floyd's algorithm - type-erased
+     *
+     * This overload merely forwards to the sponge-type-templated one.
+     *
+     * @param s  Sponge to use for randomization
+     * @param total  Total number to sample from
+     * @param size  Sample size to generate (clamped to total)
+     * @return a vector holding the sample
+     */
+    inline std::vector<std::size_t> floydSampleWithoutReplacement(Draupnir::Sponge &s, std::size_t total, std::size_t size) {
+      return floydSampleWithoutReplacement<Draupnir::Sponge>(s, total, size);
+    }
+
+    /**
+     * Generate a uniform sampling without replacement into the given range using Floyd's algorithm
+     *
+     * The hash set of elements chosen so far is kept in the given scratch
+     * space.
+     *
+     * For each j from total - size to total - 1, a random t between 0 and j
+     * is drawn, and t is added to the sample if not already present, j
+     * otherwise (note that j cannot have been chosen before).
+     *
+     * @param s  Sponge to use for randomization
+     * @param total  Total number to sample from
+     * @param first  Iterator pointing to the first element to fill
+     * @param last  Iterator pointing past the last element to fill (the sample size is clamped to total)
+     * @param scratch  Scratch space (of at least sampleScratchSize(last - first) elements)
+     * @return an iterator pointing past the last element written
+     */
+    template <typename RandomIt, typename S>
+    RandomIt floydSampleWithoutReplacement(S &s, std::size_t total, RandomIt first, RandomIt last, std::size_t *scratch) {
+      std::size_t size = std::min(static_cast<std::size_t>(last - first), total);
+
+      IndexSet chosen(scratch, IndexSet::capacityFor(size));
+      for (std::size_t j = total - size; j < total; j++, ++first) {
+        std::size_t t = natural<std::size_t>(s, j);
+        if (!chosen.insert(t)) {
+          t = j;
+          chosen.insert(t);
+        }
+        *first = t;
+      }
+      return first;
+    }
+
+    /**
+     * Generate a sorted uniform sampling without replacement as a stream
+     *
+     * Algorithm D is used while the number of elements yet to sample is
+     * below 1 / 13 of the number of elements yet to go over (as per Vitter's
+     * recommendation); the V' variate is carried over from one skip to the
+     * next whenever the rejection test allows it.
+     *
+     * @param s  Sponge to use for randomization
+     * @param total  Total number to sample from
+     * @param size  Sample size to generate (clamped to total)
+     * @param out  Iterator pointing to the first element to write
+     * @return an iterator pointing past the last element written
+     */
+    template <typename OutputIt, typename S>
+    OutputIt sortedSampleWithoutReplacement(S &s, std::size_t total, std::size_t size, OutputIt out) {
+      if (total <= size) {
+        for (std::size_t i = 0; i < total; i++) {
+          *out++ = i;
+        }
+        return out;
+      }
+
+      // n elements yet to sample out of N yet to go over, starting at next
+      std::size_t n = size, N = total, next = 0;
+
+      // Algorithm D
+      if (1 < n && n < N / 13) {
+        double vprime = std::exp(std::log(openReal(s)) / static_cast<double>(n));
+        while (1 < n && n < N / 13) {
+          double nr = static_cast<double>(n), Nr = static_cast<double>(N);
+          std::size_t qu1 = N - n + 1;
+          double qu1r = static_cast<double>(qu1);
+
+          std::size_t skip;
+          while (true) {
+            double x = Nr * (1.0 - vprime);
+            while (!(x < qu1r)) {
+              vprime = std::exp(std::log(openReal(s)) / nr);
+              x = Nr * (1.0 - vprime);
+            }
+            skip = static_cast<std::size_t>(x);
+
+            double y1 = std::exp(std::log(openReal(s) * Nr / qu1r) / (nr - 1.0));
+            vprime = y1 * (1.0 - x / Nr) * (qu1r / (qu1r - static_cast<double>(skip)));
+            if (vprime <= 1.0) {
+              break;
+            }
+
+            double y2 = 1.0, top = Nr - 1.0, bottom;
+            std::size_t limit;
+            if (skip < n - 1) {
+              bottom = Nr - nr;
+              limit = N - skip;
+            } else {
+              bottom = Nr - static_cast<double>(skip) - 1.0;
+              limit = qu1;
+            }
+            for (std::size_t t = limit; t < N; t++) {
+              y2 = y2 * top / bottom;
+              top -= 1.0;
+              bottom -= 1.0;
+            }
+            if (y1 * std::exp(std::log(y2) / (nr - 1.0)) <= Nr / (Nr - x)) {
+              vprime = std::exp(std::log(openReal(s)) / (nr - 1.0));
+              break;
+            }
+            vprime = std::exp(std::log(openReal(s)) / nr);
+          }
+
+          *out++ = next + skip;
+          next += skip + 1;
+          N -= skip + 1;
+          n--;
+        }
+      }
+
+      // Algorithm A
+      while (1 < n) {
+        double v = openReal(s), top = static_cast<double>(N - n), Nr = static_cast<double>(N);
+        double quot = top / Nr;
+        std::size_t skip = 0;
+        while (v < quot) {
+          skip++;
+          top -= 1.0;
+          Nr -= 1.0;
+          quot = quot * top / Nr;
+        }
+
+        *out++ = next + skip;
+        next += skip + 1;
+        N -= skip + 1;
+        n--;
+      }
+
+      if (1 == n) {
+        *out++ = next + std::min(N - 1, static_cast<std::size_t>(static_cast<double>(N) * openReal(s)));
+      }
+      return out;
+    }
+
+    /**
+     * Generate a sorted uniform sampling with replacement as a stream
+     *
+     * @param s  Sponge to use for randomization
+     * @param total  Total number to sample from
+     * @param size  Sample size to generate
+     * @param out  Iterator pointing to the first element to write
+     * @return an iterator pointing past the last element written
+     */
+    template <typename OutputIt, typename S>
+    OutputIt sortedSampleWithReplacement(S &s, std::size_t total, std::size_t size, OutputIt out) {
+      if (0 == total) {
+        return out;
+      }
+      double x = 0.0;
+      for (std::size_t i = 0; i < size; i++) {
+        x += exponential(s) / static_cast<double>(size - i);
+        *out++ = std::min(total - 1, static_cast<std::size_t>(-std::expm1(-x) * static_cast<double>(total)));
+      }
+      return out;
+    }
+
+    /**
+     * Generate the given number of sorted random real values between 0 and 1 as a stream
+     *
+     * @param s  Sponge to use for randomization
+     * @param size  Number of values to generate
+     * @param out  Iterator pointing to the first element to write
+     * @return an iterator pointing past the last element written
+     */
+    template <typename OutputIt, typename S>
+    OutputIt sortedReal(S &s, std::size_t size, OutputIt out) {
+      double x = 0.0;
+      for (std::size_t i = 0; i < size; i++) {
+        x += exponential(s) / static_cast<double>(size - i);
+        *out++ = -std::expm1(-x);
+      }
+      return out;
+    }
+
+    /**
+     * Determine the scratch size needed for a non-uniform sampling with replacement over the given number of parts
+     *
+     * @param count  Number of parts in the distribution
+     * @return the number of std::size_t elements of scratch space needed
+     */
+    inline std::size_t aliasScratchSize(std::size_t count) noexcept {
+      return 4 * count;
+    }
+
     /**
      * Generate a non-uniform sampling with replacement (ie. simply a vector of number yielded from a Vose method)
      *
@@ -194,47 +1860,96 @@ namespace Draupnir {
      * @param size  Sample size to generate
      * @return a vector holding the sample
      */
-    std::vector<std::size_t> nonUniformSampleWithReplacement(Draupnir::Sponge &s, std::vector<std::size_t> const &parts, std::size_t size) {
-      // copy parts to weights, set multiplicities to 1, and calculate total weight
-      std::vector<std::size_t> weight, alias, mult;
-      std::size_t num = parts.size(), total = 0;
-      for (std::size_t i = 0; i < num; i++) {
-        weight[i] = parts[i];
+    template <typename S>
+    std::vector<std::size_t> nonUniformSampleWithReplacement(S &s, std::vector<std::size_t> const &parts, std::size_t size) {
+      std::vector<std::size_t> result(size);
+      std::vector<std::size_t> scratch(aliasScratchSize(parts.size()));
+      nonUniformSampleWithReplacement(s, parts.begin(), parts.end(), result.begin(), result.end(), scratch.data());
+      return result;
+    }
+
+    /**
+     * Generate a non-uniform sampling with replacement (ie. simply a vector of number yielded from a Vose method) - type-erased
+     *
+     * This overload merely forwards to the sponge-type-templated one.
+     *
+     * @param s  Sponge to use for randomization
+     * @param parts  Distribution specified as parts-to-parts
+     * @param size  Sample size to generate
+     * @return a vector holding the sample
+     */
+    inline std::vector<std::size_t> nonUniformSampleWithReplacement(Draupnir::Sponge &s, std::vector<std::size_t> const &parts, std::size_t size) {
+      return nonUniformSampleWithReplacement<Draupnir::Sponge>(s, parts, size);
+    }
+
+    /**
+     * Generate a non-uniform sampling with replacement into the given range
+     *
+     * The alias table (and the work lists used to build it) are kept in the
+     * given scratch space: weights, aliases and multiplicities take up the
+     * first three quarters thereof, and the last quarter holds both the small
+     * and large work lists, growing from opposite ends.
+     *
+     * Column x's acceptance probability is num * weight[x] / total -
+     * (mult[x] - 1), compared in integer-scaled form.
+     *
+     * @param s  Sponge to use for randomization
+     * @param partsFirst  Iterator pointing to the first part in the distribution (specified as parts-to-parts)
+     * @param partsLast  Iterator pointing past the last part in the distribution
+     * @param first  Iterator pointing to the first element to fill
+     * @param last  Iterator pointing past the last element to fill
+     * @param scratch  Scratch space (of at least aliasScratchSize(partsLast - partsFirst) elements)
+     * @throws std::domain_error in case the distribution is empty and a non-empty sample is requested
+     */
+    template <typename PartsIt, typename ForwardIt, typename S>
+    void nonUniformSampleWithReplacement(S &s, PartsIt partsFirst, PartsIt partsLast, ForwardIt first, ForwardIt last, std::size_t *scratch) {
+      std::size_t num = static_cast<std::size_t>(std::distance(partsFirst, partsLast)), total = 0;
+      if (0 == num) {
+        if (first != last) {
+          throw std::domain_error("Empty distribution");
+        }
+        return;
+      }
+      std::size_t *weight = scratch, *alias = scratch + num, *mult = scratch + 2 * num, *work = scratch + 3 * num;
+
+      // copy parts to weights, set aliases to self and multiplicities to 1, and calculate total weight
+      for (std::size_t i = 0; i < num; i++, ++partsFirst) {
+        weight[i] = *partsFirst;
+        alias[i] = i;
         mult[i] = 1;
         total += weight[i];
       }
-      // separate large and small weights
-      std::stack<std::size_t> small, large;
+      // separate large and small weights (small ones growing upwards, large ones downwards)
+      std::size_t smallTop = 0, largeTop = num;
       for (std::size_t i = 0; i < num; i++) {
         if (num * weight[i] < total * mult[i]) {
-          small.push(i);
+          work[smallTop++] = i;
         } else {
-          large.push(i);
+          work[--largeTop] = i;
         }
       }
       // perform alias building proper
-      while (!small.empty() && !large.empty()) {
-        std::size_t l = small.top(); small.pop();
-        std::size_t g = large.top(); large.pop();
+      while (0 < smallTop && largeTop < num) {
+        std::size_t l = work[--smallTop];
+        std::size_t g = work[largeTop++];
         alias[l] = g;
-        weight[g] += weight[l]; mult[g]++;
+        // l's residual mass is given away to g, taking l's whole multiplicity along
+        weight[g] += weight[l]; mult[g] += mult[l];
         if (num * weight[g] < total * mult[g]) {
-          small.push(g);
+          work[smallTop++] = g;
         } else {
-          large.push(g);
+          work[--largeTop] = g;
         }
       }
-      // generate "size" elements
-      std::vector<std::size_t> result;
-      for (std::size_t i = 0; i < size; i++) {
-        std::size_t x = natural<std::size_t>(s, num);
-        if (total * (real(s) + mult[x]) < num * weight[x]) {
-          result[i] = x;
+      // generate the sample
+      for (; first != last; ++first) {
+        std::size_t x = natural<std::size_t>(s, num - 1);
+        if (static_cast<long double>(total) * (real(s) + static_cast<long double>(mult[x] - 1)) < static_cast<long double>(num * weight[x])) {
+          *first = x;
         } else {
-          result[i] = alias[x];
+          *first = alias[x];
         }
       }
-      return result;
     }
 
     /**
@@ -242,23 +1957,60 @@ namespace Draupnir {
      *
      * @param s  Sponge to use for randomization
      * @param parts  Distribution specified as parts-to-parts
-     * @param size  Sample size to generate
+     * @param size  Sample size to generate (clamped to the number of parts)
      * @return a vector holding the sample
      */
-    std::vector<std::size_t> nonUniformSampleWithoutReplacement(Draupnir::Sponge &s, std::vector<std::size_t> const &parts, std::size_t size) {
-      std::vector<std::size_t> result;
-      std::size_t sum = 0;
-      for (std::size_t i = 0; i < size; i++) {
-        result[i] = i;
-        sum += parts[i];
+    template <typename S>
+    std::vector<std::size_t> nonUniformSampleWithoutReplacement(S &s, std::vector<std::size_t> const &parts, std::size_t size) {
+      std::vector<std::size_t> result(std::min(size, parts.size()));
+      nonUniformSampleWithoutReplacement(s, parts.begin(), parts.end(), result.begin(), result.end());
+      return result;
+    }
+
+    /**
+     * Generate a non-uniform sampling without replacement using Chao's method - type-erased
+     *
+     * This overload merely forwards to the sponge-type-templated one.
+     *
+     * @param s  Sponge to use for randomization
+     * @param parts  Distribution specified as parts-to-parts
+     * @param size  Sample size to generate (clamped to the number of parts)
+     * @return a vector holding the sample
+     */
+    inline std::vector<std::size_t> nonUniformSampleWithoutReplacement(Draupnir::Sponge &s, std::vector<std::size_t> const &parts, std::size_t size) {
+      return nonUniformSampleWithoutReplacement<Draupnir::Sponge>(s, parts, size);
+    }
+
+    /**
+     * Generate a non-uniform sampling without replacement into the given range using Chao's method
+     *
+     * Each element beyond the first size ones replaces a random one in the
+     * sample with probability size * w / W, W being the total weight seen so
+     * far (including w's).
+     *
+     * @param s  Sponge to use for randomization
+     * @param partsFirst  Iterator pointing to the first part in the distribution (specified as parts-to-parts)
+     * @param partsLast  Iterator pointing past the last part in the distribution
+     * @param first  Iterator pointing to the first element to fill
+     * @param last  Iterator pointing past the last element to fill (the sample size is clamped to the number of parts)
+     * @return an iterator pointing past the last element written
+     */
+    template <typename PartsIt, typename RandomIt, typename S>
+    RandomIt nonUniformSampleWithoutReplacement(S &s, PartsIt partsFirst, PartsIt partsLast, RandomIt first, RandomIt last) {
+      std::size_t sum = 0, i = 0;
+      RandomIt it = first;
+      for (; it != last && partsFirst != partsLast; ++it, i++, ++partsFirst) {
+        *it = i;
+        sum += *partsFirst;
       }
-      for (std::size_t i = size; i < parts.size(); i++) {
-        if (sum * real(s) <= parts[i]) {
-          result[natural<std::size_t>(s, size - 1)] = i;
+      std::size_t size = i;
+      for (; partsFirst != partsLast; i++, ++partsFirst) {
+        sum += *partsFirst;
+        if (static_cast<long double>(sum) * real(s) < static_cast<long double>(size) * static_cast<long double>(*partsFirst)) {
+          first[static_cast<std::ptrdiff_t>(natural<std::size_t>(s, size - 1))] = i;
         }
-        sum += parts[i];
       }
-      return result;
+      return it;
     }
 
   }
@@ -266,4 +2018,3 @@ namespace Draupnir {
 }
 
 #endif /* DRAUPNIR_RANDOM_HPP__ */
-
@@ -0,0 +1,184 @@
+#ifndef DRAUPNIR_RESERVOIR_SAMPLER_H__
+#define DRAUPNIR_RESERVOIR_SAMPLER_H__
+
+#include <cstdint>
+#include <vector>
+
+#include "Sponge.h"
+
+namespace Draupnir {
+
+  namespace Random {
+
+    /**
+     * Streaming uniform sampler without replacement using Li's Algorithm L
+     *
+     * This class keeps a uniform sample of the given size out of a stream of
+     * unknown length; elements are fed one at a time via offer(), or in bulk
+     * via the iterator form thereof.
+     *
+     * Instead of drawing a random number for every element past the first
+     * "size" ones, Algorithm L draws the number of elements to be discarded
+     * before the next replacement from a geometric distribution, so that only
+     * O(size * log(n / size)) random draws are needed for a stream of length
+     * n. Producers able to skip elements cheaply (eg. by scanning for line
+     * terminators without materializing the lines) can query skip() and
+     * report the skipped elements via discard().
+     *
+     * The template parameters establish the type of the elements sampled,
+     * and the sponge type to draw from (a concrete type allows for every draw
+     * to be devirtualized).
+     *
+     */
+    template <typename T, typename S = Draupnir::Sponge>
+    class ReservoirSampler {
+      public:
+        /**
+         * Main constructor
+         *
+         * The given sponge must outlive the sampler.
+         *
+         * @param s  Sponge to use for randomization
+         * @param size  Sample size to keep
+         */
+        ReservoirSampler(S &s, std::size_t size);
+
+        /**
+         * Copy constructor - defaulted
+         *
+         * @param other  ReservoirSampler to copy from
+         */
+        ReservoirSampler(ReservoirSampler const &other) = default;
+
+        /**
+         * Move constructor - defaulted
+         *
+         * @param other  ReservoirSampler to move from
+         */
+        ReservoirSampler(ReservoirSampler &&other) noexcept = default;
+
+        /**
+         * Destructor - defaulted
+         *
+         */
+        ~ReservoirSampler() noexcept = default;
+
+        /**
+         * Retrieve the number of upcoming elements that will be discarded outright
+         *
+         * @return the number of elements that can be skipped before the next one that must be offered
+         */
+        std::size_t skip() const noexcept;
+
+        /**
+         * Account for the given number of elements having been skipped by the producer
+         *
+         * @param n  Number of elements skipped (must not exceed skip())
+         * @return the updated ReservoirSampler
+         */
+        ReservoirSampler &discard(std::size_t n) noexcept;
+
+        /**
+         * Offer a single element to the sampler
+         *
+         * @param value  Element to offer
+         * @return true if the element was kept in the sample
+         */
+        bool offer(T const &value);
+
+        /**
+         * Offer a single element to the sampler, moving from it if kept
+         *
+         * @param value  Element to offer
+         * @return true if the element was kept in the sample
+         */
+        bool offer(T &&value);
+
+        /**
+         * Offer every element in the given range to the sampler
+         *
+         * Skipped elements are merely iterated over, never dereferenced.
+         *
+         * @param first  Iterator pointing to the first element to offer
+         * @param last  Iterator pointing past the last element to offer
+         * @return the updated ReservoirSampler
+         */
+        template <typename InputIt>
+        ReservoirSampler &offer(InputIt first, InputIt last);
+
+        /**
+         * Retrieve the number of elements seen so far (whether offered or skipped)
+         *
+         * @return the number of elements seen
+         */
+        std::size_t seen() const noexcept;
+
+        /**
+         * Retrieve the current sample
+         *
+         * The sample holds min(size, seen()) elements, in no particular order.
+         *
+         * @return the current sample
+         */
+        std::vector<T> const &sample() const noexcept;
+
+      protected:
+        /**
+         * Determine whether the next offered element must be kept, and where
+         *
+         * This method updates the internal state as if an element was seen.
+         *
+         * @return the position in the sample to store the next element at (size if it is to be discarded)
+         */
+        std::size_t slot();
+
+        /**
+         * Draw the next geometric jump and update the running threshold
+         *
+         */
+        void jump();
+
+        /**
+         * Sponge to use for randomization
+         *
+         */
+        S &_sponge;
+
+        /**
+         * Sample size to keep
+         *
+         */
+        std::size_t _size;
+
+        /**
+         * Number of elements seen so far
+         *
+         */
+        std::size_t _seen;
+
+        /**
+         * Number of elements to discard before the next replacement
+         *
+         */
+        std::size_t _skip;
+
+        /**
+         * Running threshold (ie. the largest of the size smallest keys seen so far)
+         *
+         */
+        double _w;
+
+        /**
+         * Current sample
+         *
+         */
+        std::vector<T> _sample;
+    };
+
+  }
+
+}
+
+#include "ReservoirSampler.hpp"
+
+#endif /* DRAUPNIR_RESERVOIR_SAMPLER_H__ */
@@ -0,0 +1,204 @@
+#ifndef DRAUPNIR_RESERVOIR_SAMPLER_HPP__
+#define DRAUPNIR_RESERVOIR_SAMPLER_HPP__
+
+#include <cmath>
+#include <limits>
+#include <utility>
+
+#include "ReservoirSampler.h"
+#include "Random.h"
+
+namespace Draupnir {
+
+  namespace Random {
+
+    /**
+     * ReservoirSampler main constructor
+     *
+     * The given sponge must outlive the sampler.
+     *
+     * @param s  Sponge to use for randomization
+     * @param size  Sample size to keep
+     */
+    template <typename T, typename S>
+    ReservoirSampler<T, S>::ReservoirSampler(S &s, std::size_t size)
+      :
+    _sponge {s},
+    _size {size},
+    _seen {0},
+    _skip {0 == size ? std::numeric_limits<std::size_t>::max() : 0},
+    _w {1.0},
+    _sample {}
+    {
+      _sample.reserve(size);
+    }
+
+    /**
+     * Retrieve the number of upcoming elements that will be discarded outright
+     *
+     * @return the number of elements that can be skipped before the next one that must be offered
+     */
+    template <typename T, typename S>
+    std::size_t ReservoirSampler<T, S>::skip() const noexcept {
+      return _skip;
+    }
+
+    /**
+     * Account for the given number of elements having been skipped by the producer
+     *
+     * @param n  Number of elements skipped (must not exceed skip())
+     * @return the updated ReservoirSampler
+     */
+    template <typename T, typename S>
+    ReservoirSampler<T, S> &ReservoirSampler<T, S>::discard(std::size_t n) noexcept {
+      _skip -= n;
+      _seen += n;
+      return *this;
+    }
+
+    /**
+     * Offer a single element to the sampler
+     *
+     * @param value  Element to offer
+     * @return true if the element was kept in the sample
+     */
+    template <typename T, typename S>
+    bool ReservoirSampler<T, S>::offer(T const &value) {
+      std::size_t i = slot();
+      if (_size == i) {
+        return false;
+      }
+      if (_sample.size() == i) {
+        _sample.push_back(value);
+      } else {
+        _sample[i] = value;
+      }
+      return true;
+    }
+
+    /**
+     * Offer a single element to the sampler, moving from it if kept
+     *
+     * @param value  Element to offer
+     * @return true if the element was kept in the sample
+     */
+    template <typename T, typename S>
+    bool ReservoirSampler<T, S>::offer(T &&value) {
+      std::size_t i = slot();
+      if (_size == i) {
+        return false;
+      }
+      if (_sample.size() == i) {
+        _sample.push_back(std::move(value));
+      } else {
+        _sample[i] = std::move(value);
+      }
+      return true;
+    }
+
+    /**
+     * Offer every element in the given range to the sampler
+     *
+     * Skipped elements are merely iterated over, never dereferenced.
+     *
+     * @param first  Iterator pointing to the first element to offer
+     * @param last  Iterator pointing past the last element to offer
+     * @return the updated ReservoirSampler
+     */
+    template <typename T, typename S>
+    template <typename InputIt>
+    ReservoirSampler<T, S> &ReservoirSampler<T, S>::offer(InputIt first, InputIt last) {
+      while (first != last) {
+        std::size_t n = 0;
+        for (std::size_t k = _skip; n < k && first != last; n++) {
+          ++first;
+        }
+        discard(n);
+        if (first != last) {
+          offer(*first);
+          ++first;
+        }
+      }
+      return *this;
+    }
+
+    /**
+     * Retrieve the number of elements seen so far (whether offered or skipped)
+     *
+     * @return the number of elements seen
+     */
+    template <typename T, typename S>
+    std::size_t ReservoirSampler<T, S>::seen() const noexcept {
+      return _seen;
+    }
+
+    /**
+     * Retrieve the current sample
+     *
+     * The sample holds min(size, seen()) elements, in no particular order.
+     *
+     * @return the current sample
+     */
+    template <typename T, typename S>
+    std::vector<T> const &ReservoirSampler<T, S>::sample() const noexcept {
+      return _sample;
+    }
+
+    /**
+     * Determine whether the next offered element must be kept, and where
+     *
+     * This method updates the internal state as if an element was seen.
+     *
+     * @return the position in the sample to store the next element at (size if it is to be discarded)
+     */
+    template <typename T, typename S>
+    std::size_t ReservoirSampler<T, S>::slot() {
+      _seen++;
+
+      // still filling up the reservoir: draw the first jump as soon as it's full
+      if (_sample.size() < _size) {
+        std::size_t i = _sample.size();
+        if (_size == i + 1) {
+          jump();
+        }
+        return i;
+      }
+
+      // within a jump: discard
+      if (0 < _skip) {
+        _skip--;
+        return _size;
+      }
+
+      // landed: replace a random element and jump again
+      std::size_t i = natural<std::size_t>(_sponge, _size - 1);
+      jump();
+      return i;
+    }
+
+    /**
+     * Draw the next geometric jump and update the running threshold
+     *
+     * The threshold is updated by multiplying it by the maximum of size
+     * uniform variates (ie. a single uniform variate raised to 1 / size), and
+     * the jump length is drawn from the geometric distribution with success
+     * probability equal to the new threshold.
+     *
+     */
+    template <typename T, typename S>
+    void ReservoirSampler<T, S>::jump() {
+      _w *= std::exp(std::log(openReal(_sponge)) / static_cast<double>(_size));
+
+      double skip = std::floor(std::log(openReal(_sponge)) / std::log1p(-_w));
+      if (skip < static_cast<double>(std::numeric_limits<std::size_t>::max())) {
+        _skip = static_cast<std::size_t>(skip);
+      } else {
+        _skip = std::numeric_limits<std::size_t>::max();
+      }
+    }
+
+  }
+
+}
+
+#endif /* DRAUPNIR_RESERVOIR_SAMPLER_HPP__ */
@@ -0,0 +1,356 @@
+#include "Script.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+#include "LineReader.h"
+
+
+namespace {
+
+/**
+ * Determine whether the given character is a blank
+ *
+ * @param c  Character to check
+ * @return true if c is a space or a tab
+ */
+bool isBlank(char c) noexcept {
+  return ' ' == c || '\t' == c;
+}
+
+/**
+ * Extract the next blank-delimited token, advancing the given cursor past it
+ *
+ * @param p  Cursor to advance
+ * @param end  End of the line
+ * @return the token extracted (empty if the line is exhausted)
+ */
+std::string nextToken(char const *&p, char const *end) {
+  while (p < end && isBlank(*p)) {
+    p++;
+  }
+  char const *begin = p;
+  while (p < end && !isBlank(*p)) {
+    p++;
+  }
+  return std::string(begin, p);
+}
+
+/**
+ * Extract the rest of the line, skipping the blanks separating it from the previous token
+ *
+ * @param p  Cursor to advance
+ * @param end  End of the line
+ * @return the rest of the line
+ */
+std::string restOfLine(char const *&p, char const *end) {
+  while (p < end && isBlank(*p)) {
+    p++;
+  }
+  char const *begin = p;
+  p = end;
+  return std::string(begin, end);
+}
+
+/**
+ * Build the exception to throw for the given line
+ *
+ * @param number  Line number
+ * @param what  Error description
+ * @return the exception built
+ */
+std::invalid_argument lineError(std::size_t number, std::string const &what) {
+  return std::invalid_argument("Line " + std::to_string(number) + ": " + what);
+}
+
+/**
+ * Parse the given token as a natural number
+ *
+ * @param token  Token to parse
+ * @param number  Line number (for error reporting)
+ * @return the number parsed
+ * @throws std::invalid_argument in case the token is not a natural number
+ */
+std::size_t parseNatural(std::string const &token, std::size_t number) {
+  std::size_t pos = 0, value = 0;
+  try {
+    value = std::stoull(token, &pos);
+  } catch (std::exception const &) {
+    pos = 0;
+  }
+  if (token.empty() || '-' == token[0] || pos != token.size()) {
+    throw lineError(number, "Malformed number '" + token + "'");
+  }
+  return value;
+}
+
+}
+
+namespace Draupnir {
+
+/**
+ * Compile the script in the given file
+ *
+ * Lines are read through a LineReader, so that the file is mmap'ed whenever
+ * possible and scanned in a single pass.
+ *
+ * @param path  Path to the file to compile ("-" for the standard input)
+ * @return the compiled Script
+ * @throws std::system_error in case the file cannot be opened or read
+ * @throws std::invalid_argument in case the script is malformed
+ */
+Script Script::compile(std::string const &path) {
+  Script result;
+  LineReader input(path);
+  std::vector<std::size_t> blocks;
+
+  char const *line;
+  std::size_t length, number = 0;
+  while (input.next(line, length)) {
+    result.compileLine(line, length, ++number, blocks);
+  }
+  if (!blocks.empty()) {
+    throw lineError(number, "Unterminated repeat block");
+  }
+
+  return result;
+}
+
+/**
+ * Retrieve the number of instructions in the script
+ *
+ * @return the number of instructions
+ */
+std::size_t Script::size() const noexcept {
+  return _code.size();
+}
+
+/**
+ * Run the script on the given Environment
+ *
+ * Repeat blocks are run by keeping a stack of remaining iteration counts,
+ * allocated once up front to the script's maximum nesting depth.
+ *
+ * @param env  Environment to run the script on
+ * @return the resulting Environment
+ * @throws whatever Environment::load or Environment::open throw
+ */
+Environment &Script::run(Environment &env) const {
+  std::vector<std::size_t> counters;
+  counters.reserve(_depth);
+
+  for (std::size_t pc = 0; pc < _code.size(); pc++) {
+    Instruction const &ins = _code[pc];
+    switch (ins.op) {
+      case Opcode::Drop:        env.drop(ins.a);                                             break;
+      case Opcode::Copy:        env.copy(ins.a, ins.b);                                      break;
+      case Opcode::Sink:        env.sink(ins.a, ins.b);                                      break;
+      case Opcode::Raw:         env.raw(ins.a, ins.flag);                                    break;
+      case Opcode::Natural:     env.natural(ins.a, ins.b);                                   break;
+      case Opcode::Real:        env.real(_reals[ins.index], ins.b);                          break;
+      case Opcode::Permutation: env.permutation(ins.a, ins.b);                               break;
+      case Opcode::Cycle:       env.cycle(ins.a, ins.b);                                     break;
+      case Opcode::Derangement: env.derangement(ins.a, ins.b);                               break;
+      case Opcode::Sample:      env.sample(ins.a, ins.b, _parts[ins.index], ins.flag);       break;
+      case Opcode::Load:        env.load(_strings[ins.index]);                               break;
+      case Opcode::Open:        env.open(_strings[ins.index], ins.a);                        break;
+      case Opcode::Reset:       env.reset(ins.a);                                            break;
+      case Opcode::Soak:        env.soak(_strings[ins.index], ins.a);                        break;
+      case Opcode::Reseed:      env.reseed(ins.a, ins.b, ins.flag);                          break;
+      case Opcode::Step:        env.step(ins.a, ins.b);                                      break;
+      case Opcode::Echo:        env.echo(_strings[ins.index]);                               break;
+      case Opcode::Exit:        env.exit(ins.flag);                                          break;
+      case Opcode::Output:      env.output(static_cast<Environment::Format>(ins.a), ins.flag); break;
+      case Opcode::Repeat:
+        if (0 == ins.a) {
+          pc = ins.b;
+        } else {
+          counters.push_back(ins.a);
+        }
+        break;
+      case Opcode::End:
+        if (0 != --counters.back()) {
+          pc = ins.b;
+        } else {
+          counters.pop_back();
+        }
+        break;
+      default:
+        break;
+    }
+  }
+
+  return env;
+}
+
+/**
+ * Construct an empty script
+ *
+ */
+Script::Script() noexcept : _code{}, _strings{}, _reals{}, _parts{}, _depth{0} {}
+
+/**
+ * Compile the given line, appending its instruction (if any)
+ *
+ * @param line  Pointer to the line's first character
+ * @param length  Line length
+ * @param number  Line number (for error reporting)
+ * @param blocks  Indices of the Repeat instructions whose blocks are still open
+ * @throws std::invalid_argument in case the line is malformed
+ */
+void Script::compileLine(char const *line, std::size_t length, std::size_t number, std::vector<std::size_t> &blocks) {
+  char const *p = line, *end = line + length;
+  if (p < end && '\r' == end[-1]) {
+    end--;
+  }
+
+  std::string name = nextToken(p, end);
+  if (name.empty() || '#' == name[0]) {
+    return;
+  }
+
+  auto natural = [&p, end, number](std::size_t def, bool required = false) {
+    std::string token = nextToken(p, end);
+    if (token.empty()) {
+      if (required) {
+        throw lineError(number, "Missing argument");
+      }
+      return def;
+    }
+    return parseNatural(token, number);
+  };
+  auto boolean = [&natural, number](bool def) {
+    std::size_t value = natural(def ? 1 : 0);
+    if (1 < value) {
+      throw lineError(number, "Expected 0 or 1");
+    }
+    return 1 == value;
+  };
+  auto string = [&p, end, number]() {
+    std::string token = nextToken(p, end);
+    if (token.empty()) {
+      throw lineError(number, "Missing argument");
+    }
+    return token;
+  };
+  auto pool = [this](std::string &&value) {
+    _strings.push_back(std::move(value));
+    return _strings.size() - 1;
+  };
+
+  Instruction ins{0, 0, 0, Opcode::Drop, false};
+  if ("drop" == name) {
+    ins.op = Opcode::Drop;
+    ins.a = natural(1);
+  } else if ("copy" == name || "sink" == name || "step" == name) {
+    ins.op = "copy" == name ? Opcode::Copy : "sink" == name ? Opcode::Sink : Opcode::Step;
+    ins.a = natural(1);
+    ins.b = natural(1);
+  } else if ("raw" == name) {
+    ins.op = Opcode::Raw;
+    ins.a = natural(10);
+    ins.flag = boolean(false);
+  } else if ("natural" == name || "permutation" == name || "cycle" == name || "derangement" == name) {
+    ins.op = "natural" == name ? Opcode::Natural : "permutation" == name ? Opcode::Permutation : "cycle" == name ? Opcode::Cycle : Opcode::Derangement;
+    ins.a = natural(9);
+    ins.b = natural(1);
+  } else if ("real" == name) {
+    ins.op = Opcode::Real;
+    std::string token = nextToken(p, end);
+    long double high = 1.0l;
+    if (!token.empty()) {
+      std::size_t pos = 0;
+      try {
+        high = std::stold(token, &pos);
+      } catch (std::exception const &) {
+        pos = 0;
+      }
+      if (pos != token.size()) {
+        throw lineError(number, "Malformed number '" + token + "'");
+      }
+    }
+    ins.index = _reals.size();
+    _reals.push_back(high);
+    ins.b = natural(1);
+  } else if ("sample" == name) {
+    ins.op = Opcode::Sample;
+    ins.a = natural(1);
+    ins.b = natural(9);
+    ins.flag = boolean(true);
+    std::vector<std::size_t> parts;
+    for (std::string token = nextToken(p, end); !token.empty(); token = nextToken(p, end)) {
+      parts.push_back(parseNatural(token, number));
+    }
+    ins.index = _parts.size();
+    _parts.push_back(std::move(parts));
+  } else if ("load" == name) {
+    ins.op = Opcode::Load;
+    ins.index = pool(string());
+  } else if ("open" == name) {
+    ins.op = Opcode::Open;
+    ins.index = pool(string());
+    ins.a = natural(0);
+  } else if ("reset" == name) {
+    ins.op = Opcode::Reset;
+    ins.a = natural(1);
+  } else if ("soak" == name) {
+    ins.op = Opcode::Soak;
+    ins.a = natural(1, true);
+    ins.index = pool(restOfLine(p, end));
+  } else if ("reseed" == name) {
+    ins.op = Opcode::Reseed;
+    ins.a = natural(1);
+    ins.b = natural(1);
+    ins.flag = boolean(false);
+  } else if ("echo" == name) {
+    ins.op = Opcode::Echo;
+    ins.index = pool(restOfLine(p, end) + '\n');
+  } else if ("exit" == name) {
+    ins.op = Opcode::Exit;
+    ins.flag = boolean(false);
+  } else if ("output" == name) {
+    ins.op = Opcode::Output;
+    std::string format = nextToken(p, end);
+    if (format.empty() || "text" == format) {
+      ins.a = static_cast<std::size_t>(Environment::Format::Text);
+    } else if ("uint32" == format) {
+      ins.a = static_cast<std::size_t>(Environment::Format::Uint32);
+    } else if ("uint64" == format) {
+      ins.a = static_cast<std::size_t>(Environment::Format::Uint64);
+    } else if ("float64" == format) {
+      ins.a = static_cast<std::size_t>(Environment::Format::Float64);
+    } else {
+      throw lineError(number, "Unknown output format '" + format + "'");
+    }
+    std::string npy = nextToken(p, end);
+    if (!npy.empty() && "npy" != npy) {
+      throw lineError(number, "Expected 'npy'");
+    }
+    ins.flag = !npy.empty();
+  } else if ("repeat" == name) {
+    ins.op = Opcode::Repeat;
+    ins.a = natural(0, true);
+    blocks.push_back(_code.size());
+    _depth = std::max(_depth, blocks.size());
+  } else if ("end" == name) {
+    if (blocks.empty()) {
+      throw lineError(number, "Unmatched end");
+    }
+    ins.op = Opcode::End;
+    ins.b = blocks.back();
+    _code[blocks.back()].b = _code.size();
+    blocks.pop_back();
+  } else {
+    throw lineError(number, "Unknown command '" + name + "'");
+  }
+
+  std::string extra = nextToken(p, end);
+  if (!extra.empty()) {
+    throw lineError(number, "Unexpected argument '" + extra + "'");
+  }
+
+  _code.push_back(ins);
+}
+
+}
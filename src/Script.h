@@ -0,0 +1,211 @@
+#ifndef DRAUPNIR_SCRIPT_H__
+#define DRAUPNIR_SCRIPT_H__
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Environment.h"
+
+namespace Draupnir {
+
+  /**
+   * Compiled Environment command script
+   *
+   * A script is a text file holding one command per line, named after the
+   * Environment method it invokes and followed by its arguments, separated
+   * by blanks (trailing arguments may be omitted, their defaults being taken
+   * from Environment); empty lines and lines starting with '#' are ignored:
+   *
+   *   drop [n]                     copy [n] [m]             sink [n] [m]
+   *   raw [count] [hex]            natural [high] [count]   real [high] [count]
+   *   permutation [highElem] [count]                        cycle [highElem] [count]
+   *   derangement [highElem] [count]
+   *   sample [count] [highElem] [replacements] [part ...]
+   *   load <dump>                  open <file> [count]      reset [n]
+   *   soak <n> <data>              reseed [m] [n] [independent]
+   *   step [n] [m]                 echo <text>              exit [silent]
+   *   output [text|uint32|uint64|float64] [npy]
+   *
+   * Boolean arguments are given as 0 or 1 (save for output's npy, given as
+   * the keyword itself); soak's data and echo's text span the rest of the
+   * line (echo's text being followed by a newline).
+   *
+   * Additionally, "repeat <count>" and "end" delimit a block of commands to
+   * be run the given number of times (blocks may be nested).
+   *
+   * The whole file is tokenized in one pass when compiling, yielding a
+   * compact instruction array whose string and list operands are kept in
+   * side pools, so that running the script involves no parsing nor
+   * allocation on the interpreter's part.
+   *
+   */
+  class Script {
+    public:
+      /**
+       * Compile the script in the given file
+       *
+       * @param path  Path to the file to compile ("-" for the standard input)
+       * @return the compiled Script
+       * @throws std::system_error in case the file cannot be opened or read
+       * @throws std::invalid_argument in case the script is malformed
+       */
+      static Script compile(std::string const &path);
+
+      /**
+       * Copy constructor - defaulted
+       *
+       * @param other  Script to copy from
+       */
+      Script(Script const &other) = default;
+
+      /**
+       * Move constructor - defaulted
+       *
+       * @param other  Script to move from
+       */
+      Script(Script &&other) noexcept = default;
+
+      /**
+       * Assignment operator - defaulted
+       *
+       * @param other  Script to assign
+       * @return the newly assigned Script
+       */
+      Script &operator=(Script const &other) = default;
+
+      /**
+       * Move-assignment operator - defaulted
+       *
+       * @param other  Script to move-assign
+       * @return the newly move-assigned Script
+       */
+      Script &operator=(Script &&other) noexcept = default;
+
+      /**
+       * Destructor - defaulted
+       *
+       */
+      ~Script() noexcept = default;
+
+      /**
+       * Retrieve the number of instructions in the script
+       *
+       * @return the number of instructions
+       */
+      std::size_t size() const noexcept __attribute__((pure));
+
+      /**
+       * Run the script on the given Environment
+       *
+       * @param env  Environment to run the script on
+       * @return the resulting Environment
+       * @throws whatever Environment::load or Environment::open throw
+       */
+      Environment &run(Environment &env) const;
+
+    protected:
+      /**
+       * Instruction opcodes
+       *
+       */
+      enum class Opcode : std::uint8_t {
+        Drop, Copy, Sink,
+        Raw, Natural, Real, Permutation, Cycle, Derangement, Sample,
+        Load, Open, Reset, Soak, Reseed, Step,
+        Echo, Exit, Output,
+        Repeat, End,
+      };
+
+      /**
+       * Single compiled instruction
+       *
+       * The meaning of each operand depends on the opcode: numeric arguments
+       * are held as is, while string, real, and list arguments are held as
+       * indices into the corresponding pool; for Repeat and End, b holds the
+       * index of the matching instruction.
+       *
+       */
+      struct Instruction {
+        /**
+         * First operand
+         *
+         */
+        std::size_t a;
+
+        /**
+         * Second operand
+         *
+         */
+        std::size_t b;
+
+        /**
+         * Pool index operand
+         *
+         */
+        std::size_t index;
+
+        /**
+         * Opcode
+         *
+         */
+        Opcode op;
+
+        /**
+         * Boolean operand
+         *
+         */
+        bool flag;
+      };
+
+      /**
+       * Construct an empty script
+       *
+       */
+      Script() noexcept;
+
+      /**
+       * Compile the given line, appending its instruction (if any)
+       *
+       * @param line  Pointer to the line's first character
+       * @param length  Line length
+       * @param number  Line number (for error reporting)
+       * @param blocks  Indices of the Repeat instructions whose blocks are still open
+       * @throws std::invalid_argument in case the line is malformed
+       */
+      void compileLine(char const *line, std::size_t length, std::size_t number, std::vector<std::size_t> &blocks);
+
+      /**
+       * Compiled instructions
+       *
+       */
+      std::vector<Instruction> _code;
+
+      /**
+       * String operands pool
+       *
+       */
+      std::vector<std::string> _strings;
+
+      /**
+       * Real operands pool
+       *
+       */
+      std::vector<long double> _reals;
+
+      /**
+       * Part lists pool
+       *
+       */
+      std::vector<std::vector<std::size_t>> _parts;
+
+      /**
+       * Maximum repeat block nesting depth
+       *
+       */
+      std::size_t _depth;
+  };
+
+}
+
+#endif /* DRAUPNIR_SCRIPT_H__ */
@@ -14,7 +14,8 @@ namespace Draupnir {
    *
    *   - squeeze: squeeze a SINGLE BYTE from the sponge (this simplification
    *       allows for each sponge to implement its own buffering and still yield
-   *       a uniform interface),
+   *       a uniform interface), or squeeze a whole byte array at once (yielding
+   *       the very same bytes as repeated single byte squeezes would),
    *   - soak: soak a byte array into the sponge,
    *   - step: apply a single transformation step (this allows for users to apply
    *       any arbitrary stepping policy beyond that of the strictly necessary
@@ -47,6 +48,15 @@ namespace Draupnir {
        */
       virtual std::uint8_t squeeze() noexcept = 0;
 
+      /**
+       * Squeeze the given number of bytes from the sponge - pure virtual
+       *
+       * @param data  Byte array to squeeze into
+       * @param count  Number of bytes to squeeze
+       * @return the squeezed sponge
+       */
+      virtual Sponge &squeeze(std::uint8_t *data, std::size_t count) noexcept = 0;
+
       /**
        * Soak a string into the sponge - pure virtual
        *
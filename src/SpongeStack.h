@@ -0,0 +1,254 @@
+#ifndef DRAUPNIR_SPONGE_STACK_H__
+#define DRAUPNIR_SPONGE_STACK_H__
+
+#include <cstdint>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "CrcSponge.h"
+#include "ThreadPool.h"
+
+namespace Draupnir {
+
+  /**
+   * Stack of CrcSponges of mixed widths, kept in per-width contiguous pools
+   *
+   * Rather than keeping every sponge in its own heap allocation behind a
+   * Sponge pointer, this class keeps one contiguous pool per width (ie. a
+   * std::vector of CrcSponge8, CrcSponge16, CrcSponge32, and CrcSponge64
+   * each), along with the width of the sponge at each stack position; since
+   * every pool holds its sponges in stack order, the topmost n sponges in the
+   * stack are always the last ones in each pool, so that operating on them
+   * amounts to a linear scan over the tail of each pool, with no virtual
+   * dispatch involved.
+   *
+   * Visitor functions are called with a reference to the concrete CrcSponge
+   * type at hand, and should thus be generic (eg. a generic lambda).
+   *
+   */
+  class SpongeStack {
+    public:
+      /**
+       * Construct an empty stack
+       *
+       */
+      SpongeStack() noexcept;
+
+      /**
+       * Copy constructor - defaulted
+       *
+       * @param other  SpongeStack to copy from
+       */
+      SpongeStack(SpongeStack const &other) = default;
+
+      /**
+       * Move constructor - defaulted
+       *
+       * @param other  SpongeStack to move from
+       */
+      SpongeStack(SpongeStack &&other) noexcept = default;
+
+      /**
+       * Assignment operator - defaulted
+       *
+       * @param other  SpongeStack to assign
+       * @return the newly assigned SpongeStack
+       */
+      SpongeStack &operator=(SpongeStack const &other) = default;
+
+      /**
+       * Move-assignment operator - defaulted
+       *
+       * @param other  SpongeStack to move-assign
+       * @return the newly move-assigned SpongeStack
+       */
+      SpongeStack &operator=(SpongeStack &&other) noexcept = default;
+
+      /**
+       * Destructor - defaulted
+       *
+       */
+      ~SpongeStack() noexcept = default;
+
+      /**
+       * Retrieve the number of sponges in the stack
+       *
+       * @return the number of sponges in the stack
+       */
+      std::size_t size() const noexcept;
+
+      /**
+       * Determine whether the stack is empty
+       *
+       * @return true if the stack holds no sponges
+       */
+      bool empty() const noexcept;
+
+      /**
+       * Push the given sponge to the top of the stack
+       *
+       * @param sponge  Sponge to push
+       * @return the resulting SpongeStack
+       */
+      template <typename T>
+      SpongeStack &push(CrcSponge<T> const &sponge);
+
+      /**
+       * Unserialize the given state and push it to the top of the stack
+       *
+       * @param dump  Dumped state
+       * @param delim  Delimiter character to use (defaults to ':')
+       * @return the resulting SpongeStack
+       * @throws std::invalid_argument in case the dump is malformed
+       * @throws std::domain_error in case the width specified in the dump is not supported
+       * @throws whatever CrcSponge::load throws
+       */
+      SpongeStack &load(std::string const &dump, char delim = ':');
+
+      /**
+       * Remove the given number of sponges from the top of the stack
+       *
+       * @param n  Number of sponges to remove
+       * @return the resulting SpongeStack
+       */
+      SpongeStack &drop(std::size_t n = 1) noexcept;
+
+      /**
+       * Copy the given number of sponges at the top of the stack the given number of times
+       *
+       * @param n  Number of times to copy
+       * @param m  Number of sponges to copy
+       * @return the resulting SpongeStack
+       */
+      SpongeStack &copy(std::size_t n = 1, std::size_t m = 1);
+
+      /**
+       * Move the given number of sponges downwards from the top of the stack the given number of positions
+       *
+       * @param n  Number of sponges to move
+       * @param m  Number of positions to move them
+       * @return the resulting SpongeStack
+       */
+      SpongeStack &sink(std::size_t n = 1, std::size_t m = 1) noexcept;
+
+      /**
+       * Call the given function on the sponge at the given depth
+       *
+       * Nothing is done if the stack is not deep enough.
+       *
+       * @param depth  Depth of the sponge to visit (0 being the topmost one)
+       * @param fn  Function to call
+       */
+      template <typename F>
+      void at(std::size_t depth, F const &fn);
+
+      /**
+       * Call the given function on the topmost sponge
+       *
+       * Nothing is done if the stack is empty.
+       *
+       * @param fn  Function to call
+       */
+      template <typename F>
+      void top(F const &fn);
+
+      /**
+       * Call the given function on each of the given number of sponges from the top of the stack, using the given thread pool (if any)
+       *
+       * Sponges are handed out to the pool's threads in contiguous chunks, so
+       * that no assumption should be made as to the order in which they are
+       * visited; since each sponge is visited exactly once, the results are
+       * nonetheless the same regardless of the pool used (if any), as long as
+       * the function only touches the sponge it is given.
+       *
+       * @param n  Number of sponges to visit
+       * @param fn  Function to call
+       * @param threadPool  Thread pool to use (nullptr to visit them all on the calling thread)
+       * @throws whatever fn throws
+       */
+      template <typename F>
+      void top(std::size_t n, F const &fn, ThreadPool *threadPool = nullptr);
+
+      /**
+       * Call the given function on each of the given number of sponges from the top of the stack, along with its depth, using the given thread pool (if any)
+       *
+       * As with top(), no assumption should be made as to the order in which
+       * sponges are visited; the depth given (0 being the topmost sponge) may
+       * be used to tell them apart deterministically.
+       *
+       * @param n  Number of sponges to visit
+       * @param fn  Function to call (with the sponge and its depth)
+       * @param threadPool  Thread pool to use (nullptr to visit them all on the calling thread)
+       * @throws whatever fn throws
+       */
+      template <typename F>
+      void topIndexed(std::size_t n, F const &fn, ThreadPool *threadPool = nullptr);
+
+      /**
+       * Call the given function on each sponge in the stack, from the bottom up
+       *
+       * @param fn  Function to call
+       */
+      template <typename F>
+      void each(F const &fn) const;
+
+    protected:
+      /**
+       * Number of pools (ie. of supported widths)
+       *
+       */
+      static constexpr std::size_t pools = 4;
+
+      /**
+       * Determine the pool index for the given word type
+       *
+       * @return the index of the pool holding CrcSponge<T>
+       */
+      template <typename T>
+      static constexpr std::uint8_t poolIndex() noexcept;
+
+      /**
+       * Count the sponges of each width among the given number of sponges from the top of the stack
+       *
+       * @param n  Number of sponges to count (clamped to the stack's size)
+       * @param counts  Output number of sponges of each width
+       */
+      void countTop(std::size_t n, std::size_t (&counts)[pools]) const noexcept;
+
+      /**
+       * Call the given function on the given pool
+       *
+       * @param index  Pool index
+       * @param fn  Function to call with the pool (a std::vector of the concrete CrcSponge type)
+       */
+      template <typename F>
+      void visitPool(std::size_t index, F const &fn);
+
+      /**
+       * Call the given function on the given pool - const version
+       *
+       * @param index  Pool index
+       * @param fn  Function to call with the pool (a const std::vector of the concrete CrcSponge type)
+       */
+      template <typename F>
+      void visitPool(std::size_t index, F const &fn) const;
+
+      /**
+       * Per-width sponge pools, in stack order
+       *
+       */
+      std::tuple<std::vector<CrcSponge<std::uint8_t>>, std::vector<CrcSponge<std::uint16_t>>, std::vector<CrcSponge<std::uint32_t>>, std::vector<CrcSponge<std::uint64_t>>> _pools;
+
+      /**
+       * Pool index of the sponge at each stack position, from the bottom up
+       *
+       */
+      std::vector<std::uint8_t> _widths;
+  };
+
+}
+
+#include "SpongeStack.hpp"
+
+#endif /* DRAUPNIR_SPONGE_STACK_H__ */
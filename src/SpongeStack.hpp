@@ -0,0 +1,359 @@
+#ifndef DRAUPNIR_SPONGE_STACK_HPP__
+#define DRAUPNIR_SPONGE_STACK_HPP__
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+
+#include "SpongeStack.h"
+
+namespace Draupnir {
+
+  /**
+   * Construct an empty stack
+   *
+   */
+  inline SpongeStack::SpongeStack() noexcept : _pools{}, _widths{} {}
+
+  /**
+   * Retrieve the number of sponges in the stack
+   *
+   * @return the number of sponges in the stack
+   */
+  inline std::size_t SpongeStack::size() const noexcept {
+    return _widths.size();
+  }
+
+  /**
+   * Determine whether the stack is empty
+   *
+   * @return true if the stack holds no sponges
+   */
+  inline bool SpongeStack::empty() const noexcept {
+    return _widths.empty();
+  }
+
+  /**
+   * Determine the pool index for the given word type
+   *
+   * @return the index of the pool holding CrcSponge<T>
+   */
+  template <typename T>
+  constexpr std::uint8_t SpongeStack::poolIndex() noexcept {
+    return 1 == sizeof(T) ? 0 : 2 == sizeof(T) ? 1 : 4 == sizeof(T) ? 2 : 3;
+  }
+
+  /**
+   * Push the given sponge to the top of the stack
+   *
+   * @param sponge  Sponge to push
+   * @return the resulting SpongeStack
+   */
+  template <typename T>
+  SpongeStack &SpongeStack::push(CrcSponge<T> const &sponge) {
+    std::get<poolIndex<T>()>(_pools).push_back(sponge);
+    _widths.push_back(poolIndex<T>());
+    return *this;
+  }
+
+  /**
+   * Unserialize the given state and push it to the top of the stack
+   *
+   * The width is read off the dump's fourth segment, and the dump proper is
+   * then handed over to the corresponding CrcSponge::load.
+   *
+   * @param dump  Dumped state
+   * @param delim  Delimiter character to use (defaults to ':')
+   * @return the resulting SpongeStack
+   * @throws std::invalid_argument in case the dump is malformed
+   * @throws std::domain_error in case the width specified in the dump is not supported
+   * @throws whatever CrcSponge::load throws
+   */
+  inline SpongeStack &SpongeStack::load(std::string const &dump, char delim) {
+    std::size_t begin = 0;
+    for (int i = 0; i < 3; i++) {
+      begin = dump.find(delim, begin);
+      if (std::string::npos == begin) {
+        throw std::invalid_argument("Malformed dump");
+      }
+      begin++;
+    }
+    std::string width = dump.substr(begin, dump.find(delim, begin) - begin);
+
+    switch (std::stoull(width, nullptr, 16)) {
+      case 8:
+        return push(CrcSponge<std::uint8_t>::load(dump, delim));
+      case 16:
+        return push(CrcSponge<std::uint16_t>::load(dump, delim));
+      case 32:
+        return push(CrcSponge<std::uint32_t>::load(dump, delim));
+      case 64:
+        return push(CrcSponge<std::uint64_t>::load(dump, delim));
+      default:
+        throw std::domain_error("Unsupported width: '" + width + "'");
+    }
+  }
+
+  /**
+   * Remove the given number of sponges from the top of the stack
+   *
+   * @param n  Number of sponges to remove
+   * @return the resulting SpongeStack
+   */
+  inline SpongeStack &SpongeStack::drop(std::size_t n) noexcept {
+    n = std::min(n, _widths.size());
+
+    std::size_t counts[pools];
+    countTop(n, counts);
+    for (std::size_t k = 0; k < pools; k++) {
+      visitPool(k, [&counts, k](auto &pool) {
+        pool.erase(pool.end() - static_cast<std::ptrdiff_t>(counts[k]), pool.end());
+      });
+    }
+    _widths.erase(_widths.end() - static_cast<std::ptrdiff_t>(n), _widths.end());
+
+    return *this;
+  }
+
+  /**
+   * Copy the given number of sponges at the top of the stack the given number of times
+   *
+   * Each pool is grown once, and its topmost sponges appended to it as many
+   * times as requested.
+   *
+   * @param n  Number of times to copy
+   * @param m  Number of sponges to copy
+   * @return the resulting SpongeStack
+   */
+  inline SpongeStack &SpongeStack::copy(std::size_t n, std::size_t m) {
+    m = std::min(m, _widths.size());
+    if (0 == m || 0 == n) {
+      return *this;
+    }
+
+    std::size_t counts[pools];
+    countTop(m, counts);
+    for (std::size_t k = 0; k < pools; k++) {
+      visitPool(k, [&counts, k, n](auto &pool) {
+        std::size_t end = pool.size();
+        pool.reserve(end + n * counts[k]);
+        for (std::size_t i = 0; i < n; i++) {
+          for (std::size_t j = end - counts[k]; j < end; j++) {
+            pool.push_back(pool[j]);
+          }
+        }
+      });
+    }
+
+    std::size_t end = _widths.size();
+    _widths.reserve(end + n * m);
+    for (std::size_t i = 0; i < n; i++) {
+      for (std::size_t j = end - m; j < end; j++) {
+        _widths.push_back(_widths[j]);
+      }
+    }
+
+    return *this;
+  }
+
+  /**
+   * Move the given number of sponges downwards from the top of the stack the given number of positions
+   *
+   * Within each pool, this amounts to rotating the tail holding the sponges
+   * involved, by the number of them being moved.
+   *
+   * @param n  Number of sponges to move
+   * @param m  Number of positions to move them
+   * @return the resulting SpongeStack
+   */
+  inline SpongeStack &SpongeStack::sink(std::size_t n, std::size_t m) noexcept {
+    n = std::min(n, _widths.size());
+    m = std::min(m, _widths.size() - n);
+    if (0 == n || 0 == m) {
+      return *this;
+    }
+
+    std::size_t moved[pools], involved[pools];
+    countTop(n, moved);
+    countTop(n + m, involved);
+    for (std::size_t k = 0; k < pools; k++) {
+      visitPool(k, [&moved, &involved, k](auto &pool) {
+        std::rotate(pool.end() - static_cast<std::ptrdiff_t>(involved[k]), pool.end() - static_cast<std::ptrdiff_t>(moved[k]), pool.end());
+      });
+    }
+    std::rotate(_widths.end() - static_cast<std::ptrdiff_t>(n + m), _widths.end() - static_cast<std::ptrdiff_t>(n), _widths.end());
+
+    return *this;
+  }
+
+  /**
+   * Call the given function on the sponge at the given depth
+   *
+   * The sponge's position within its pool is found by counting the sponges
+   * of the same width above it.
+   *
+   * @param depth  Depth of the sponge to visit (0 being the topmost one)
+   * @param fn  Function to call
+   */
+  template <typename F>
+  void SpongeStack::at(std::size_t depth, F const &fn) {
+    if (_widths.size() <= depth) {
+      return;
+    }
+
+    std::size_t k = _widths[_widths.size() - 1 - depth];
+    std::size_t above = 0;
+    for (std::size_t i = _widths.size() - depth; i < _widths.size(); i++) {
+      if (k == _widths[i]) {
+        above++;
+      }
+    }
+    visitPool(k, [&fn, above](auto &pool) { fn(pool[pool.size() - 1 - above]); });
+  }
+
+  /**
+   * Call the given function on the topmost sponge
+   *
+   * @param fn  Function to call
+   */
+  template <typename F>
+  void SpongeStack::top(F const &fn) {
+    at(0, fn);
+  }
+
+  /**
+   * Call the given function on each of the given number of sponges from the top of the stack, using the given thread pool (if any)
+   *
+   * @param n  Number of sponges to visit
+   * @param fn  Function to call
+   * @param threadPool  Thread pool to use (nullptr to visit them all on the calling thread)
+   * @throws whatever fn throws
+   */
+  template <typename F>
+  void SpongeStack::top(std::size_t n, F const &fn, ThreadPool *threadPool) {
+    topIndexed(n, [&fn](auto &sponge, std::size_t) { fn(sponge); }, threadPool);
+  }
+
+  /**
+   * Call the given function on each of the given number of sponges from the top of the stack, along with its depth, using the given thread pool (if any)
+   *
+   * The position of each sponge involved within its pool is found by
+   * scanning the stack downwards from the top and counting the sponges of
+   * each width seen so far; when running on more than one thread, these are
+   * all found up front, and consecutive depths are then handed out in
+   * contiguous chunks (so that sponges sharing a cache line mostly end up
+   * being visited by the same thread).
+   *
+   * @param n  Number of sponges to visit
+   * @param fn  Function to call (with the sponge and its depth)
+   * @param threadPool  Thread pool to use (nullptr to visit them all on the calling thread)
+   * @throws whatever fn throws
+   */
+  template <typename F>
+  void SpongeStack::topIndexed(std::size_t n, F const &fn, ThreadPool *threadPool) {
+    n = std::min(n, _widths.size());
+
+    std::size_t next[pools];
+    for (std::size_t k = 0; k < pools; k++) {
+      visitPool(k, [&next, k](auto const &pool) { next[k] = pool.size(); });
+    }
+
+    if (nullptr == threadPool || 1 == threadPool->size() || n <= 1) {
+      for (std::size_t depth = 0; depth < n; depth++) {
+        std::size_t k = _widths[_widths.size() - 1 - depth];
+        visitPool(k, [&fn, &next, depth, k](auto &pool) { fn(pool[--next[k]], depth); });
+      }
+      return;
+    }
+
+    std::vector<std::size_t> positions(n);
+    for (std::size_t depth = 0; depth < n; depth++) {
+      positions[depth] = --next[_widths[_widths.size() - 1 - depth]];
+    }
+
+    threadPool->run(n, [this, &fn, &positions](std::size_t begin, std::size_t end) {
+      for (std::size_t depth = begin; depth < end; depth++) {
+        visitPool(_widths[_widths.size() - 1 - depth], [&fn, &positions, depth](auto &pool) {
+          fn(pool[positions[depth]], depth);
+        });
+      }
+    });
+  }
+
+  /**
+   * Call the given function on each sponge in the stack, from the bottom up
+   *
+   * @param fn  Function to call
+   */
+  template <typename F>
+  void SpongeStack::each(F const &fn) const {
+    std::size_t next[pools] = {0, 0, 0, 0};
+    for (std::size_t k : _widths) {
+      visitPool(k, [&fn, &next, k](auto const &pool) { fn(pool[next[k]++]); });
+    }
+  }
+
+  /**
+   * Count the sponges of each width among the given number of sponges from the top of the stack
+   *
+   * @param n  Number of sponges to count (clamped to the stack's size)
+   * @param counts  Output number of sponges of each width
+   */
+  inline void SpongeStack::countTop(std::size_t n, std::size_t (&counts)[pools]) const noexcept {
+    std::fill(counts, counts + pools, 0);
+    for (std::size_t i = _widths.size() - std::min(n, _widths.size()); i < _widths.size(); i++) {
+      counts[_widths[i]]++;
+    }
+  }
+
+  /**
+   * Call the given function on the given pool
+   *
+   * @param index  Pool index
+   * @param fn  Function to call with the pool (a std::vector of the concrete CrcSponge type)
+   */
+  template <typename F>
+  void SpongeStack::visitPool(std::size_t index, F const &fn) {
+    switch (index) {
+      case 0:
+        fn(std::get<0>(_pools));
+        break;
+      case 1:
+        fn(std::get<1>(_pools));
+        break;
+      case 2:
+        fn(std::get<2>(_pools));
+        break;
+      default:
+        fn(std::get<3>(_pools));
+        break;
+    }
+  }
+
+  /**
+   * Call the given function on the given pool - const version
+   *
+   * @param index  Pool index
+   * @param fn  Function to call with the pool (a const std::vector of the concrete CrcSponge type)
+   */
+  template <typename F>
+  void SpongeStack::visitPool(std::size_t index, F const &fn) const {
+    switch (index) {
+      case 0:
+        fn(std::get<0>(_pools));
+        break;
+      case 1:
+        fn(std::get<1>(_pools));
+        break;
+      case 2:
+        fn(std::get<2>(_pools));
+        break;
+      default:
+        fn(std::get<3>(_pools));
+        break;
+    }
+  }
+
+}
+
+#endif /* DRAUPNIR_SPONGE_STACK_HPP__ */
@@ -0,0 +1,172 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+
+namespace {
+
+/**
+ * Number of chunks to split each loop into per thread in the pool
+ *
+ */
+constexpr std::size_t threadPoolChunksPerThread = 4;
+
+}
+
+namespace Draupnir {
+
+/**
+ * Construct a new ThreadPool with the given number of threads (the calling thread included)
+ *
+ * @param threads  Number of threads to use (0 to use the hardware concurrency)
+ * @throws std::system_error in case a worker thread cannot be started
+ */
+ThreadPool::ThreadPool(std::size_t threads) : _workers{}, _fn{nullptr}, _count{0}, _chunks{0}, _next{0}, _pending{0}, _generation{0}, _error{}, _mutex{}, _start{}, _done{} {
+  if (0 == threads) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  _workers.reserve(threads - 1);
+  try {
+    for (std::size_t t = 1; t < threads; t++) {
+      _workers.emplace_back(&ThreadPool::loop, this);
+    }
+  } catch (...) {
+    stop();
+    throw;
+  }
+}
+
+/**
+ * Destructor - stop and join every worker thread
+ *
+ */
+ThreadPool::~ThreadPool() noexcept {
+  stop();
+}
+
+/**
+ * Retrieve the number of threads in the pool (the calling thread included)
+ *
+ * @return the number of threads in the pool
+ */
+std::size_t ThreadPool::size() const noexcept {
+  return _workers.size() + 1;
+}
+
+/**
+ * Run the given function on every contiguous chunk of the range from 0 to count - 1
+ *
+ * @param count  Number of indices in the range
+ * @param fn  Function to run on each chunk
+ * @throws whatever fn throws
+ */
+void ThreadPool::run(std::size_t count, std::function<void(std::size_t, std::size_t)> const &fn) {
+  if (0 == count) {
+    return;
+  }
+  if (_workers.empty() || 1 == count) {
+    fn(0, count);
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _fn = &fn;
+    _count = count;
+    _chunks = std::min(count, threadPoolChunksPerThread * size());
+    _next = 0;
+    _pending = _workers.size();
+    _error = nullptr;
+    _generation++;
+  }
+  _start.notify_all();
+
+  work();
+
+  std::exception_ptr error;
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    _done.wait(lock, [this]() { return 0 == _pending; });
+    _fn = nullptr;
+    error = _error;
+    _error = nullptr;
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+/**
+ * Stop and join every worker thread
+ *
+ * Stopping is signalled by starting a new generation with no function to
+ * run.
+ *
+ */
+void ThreadPool::stop() noexcept {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _fn = nullptr;
+    _generation++;
+  }
+  _start.notify_all();
+  for (auto &worker : _workers) {
+    worker.join();
+  }
+}
+
+/**
+ * Wait for loops to run, and work on them, until stopped
+ *
+ */
+void ThreadPool::loop() noexcept {
+  std::uint64_t seen = 0;
+  std::unique_lock<std::mutex> lock(_mutex);
+  for (;;) {
+    _start.wait(lock, [this, &seen]() { return seen != _generation; });
+    seen = _generation;
+    if (nullptr == _fn) {
+      return;
+    }
+
+    lock.unlock();
+    work();
+    lock.lock();
+
+    if (0 == --_pending) {
+      _done.notify_one();
+    }
+  }
+}
+
+/**
+ * Claim and run chunks of the current loop, until none are left
+ *
+ * Chunk c spans the indices from c * count / chunks up to (but excluding)
+ * (c + 1) * count / chunks.
+ *
+ */
+void ThreadPool::work() noexcept {
+  for (;;) {
+    std::size_t chunk;
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      if (_chunks <= _next) {
+        return;
+      }
+      chunk = _next++;
+    }
+
+    try {
+      (*_fn)(chunk * _count / _chunks, (chunk + 1) * _count / _chunks);
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(_mutex);
+      if (!_error) {
+        _error = std::current_exception();
+      }
+      _next = _chunks;
+    }
+  }
+}
+
+}
@@ -0,0 +1,176 @@
+#ifndef DRAUPNIR_THREAD_POOL_H__
+#define DRAUPNIR_THREAD_POOL_H__
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Draupnir {
+
+  /**
+   * Persistent pool of worker threads running chunked parallel loops
+   *
+   * Worker threads are started once, upon construction, and sleep on a
+   * condition variable between loops, so that running a loop costs a single
+   * wake-up per worker, rather than a thread creation and join.
+   *
+   * Loops are split into several contiguous chunks per thread in the pool
+   * (the calling thread included), each claimed by whichever thread becomes
+   * idle first: contiguous chunks keep every thread away from the others'
+   * data save at chunk boundaries, while having more chunks than threads
+   * balances uneven per-index work (eg. mixed sponge widths), a thread
+   * stuck on a slow chunk leaving the remaining ones to the others.
+   *
+   * A ThreadPool must be driven from a single thread at a time.
+   *
+   */
+  class ThreadPool {
+    public:
+      /**
+       * Construct a new ThreadPool with the given number of threads (the calling thread included)
+       *
+       * @param threads  Number of threads to use (0 to use the hardware concurrency)
+       * @throws std::system_error in case a worker thread cannot be started
+       */
+      explicit ThreadPool(std::size_t threads = 0);
+
+      /**
+       * Copy constructor - deleted
+       *
+       * @param other  ThreadPool to copy from
+       */
+      ThreadPool(ThreadPool const &other) = delete;
+
+      /**
+       * Assignment operator - deleted
+       *
+       * @param other  ThreadPool to assign
+       * @return the newly assigned ThreadPool
+       */
+      ThreadPool &operator=(ThreadPool const &other) = delete;
+
+      /**
+       * Destructor - stop and join every worker thread
+       *
+       */
+      ~ThreadPool() noexcept;
+
+      /**
+       * Retrieve the number of threads in the pool (the calling thread included)
+       *
+       * @return the number of threads in the pool
+       */
+      std::size_t size() const noexcept __attribute__((pure));
+
+      /**
+       * Run the given function on every contiguous chunk of the range from 0 to count - 1
+       *
+       * The function is called with the first index in its chunk and the one
+       * past its last; no assumption should be made as to which thread runs
+       * which chunk, or in which order. The calling thread takes part in the
+       * work, and the whole range is run by it alone if the pool has a single
+       * thread or the range a single index.
+       *
+       * Should the function throw, no further chunks are handed out, and the
+       * first exception thrown is rethrown once every thread is done.
+       *
+       * @param count  Number of indices in the range
+       * @param fn  Function to run on each chunk
+       * @throws whatever fn throws
+       */
+      void run(std::size_t count, std::function<void(std::size_t, std::size_t)> const &fn);
+
+    protected:
+      /**
+       * Stop and join every worker thread
+       *
+       */
+      void stop() noexcept;
+
+      /**
+       * Wait for loops to run, and work on them, until stopped
+       *
+       */
+      void loop() noexcept;
+
+      /**
+       * Claim and run chunks of the current loop, until none are left
+       *
+       */
+      void work() noexcept;
+
+      /**
+       * Worker threads
+       *
+       */
+      std::vector<std::thread> _workers;
+
+      /**
+       * Function run on each chunk of the current loop (nullptr once the worker threads should stop)
+       *
+       */
+      std::function<void(std::size_t, std::size_t)> const *_fn;
+
+      /**
+       * Number of indices in the current loop
+       *
+       */
+      std::size_t _count;
+
+      /**
+       * Number of chunks in the current loop
+       *
+       */
+      std::size_t _chunks;
+
+      /**
+       * Next chunk to hand out in the current loop
+       *
+       */
+      std::size_t _next;
+
+      /**
+       * Number of worker threads yet to finish the current loop
+       *
+       */
+      std::size_t _pending;
+
+      /**
+       * Number of loops started so far (workers wake up whenever it changes)
+       *
+       */
+      std::uint64_t _generation;
+
+      /**
+       * First exception thrown in the current loop
+       *
+       */
+      std::exception_ptr _error;
+
+      /**
+       * Mutex guarding the loop state
+       *
+       */
+      std::mutex _mutex;
+
+      /**
+       * Condition variable signalling a loop start (or a stop request) to the workers
+       *
+       */
+      std::condition_variable _start;
+
+      /**
+       * Condition variable signalling the last worker finishing a loop
+       *
+       */
+      std::condition_variable _done;
+  };
+
+}
+
+#endif /* DRAUPNIR_THREAD_POOL_H__ */
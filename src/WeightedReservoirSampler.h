@@ -0,0 +1,205 @@
+#ifndef DRAUPNIR_WEIGHTED_RESERVOIR_SAMPLER_H__
+#define DRAUPNIR_WEIGHTED_RESERVOIR_SAMPLER_H__
+
+#include <cstdint>
+#include <vector>
+
+#include "Sponge.h"
+
+namespace Draupnir {
+
+  namespace Random {
+
+    /**
+     * Streaming weighted sampler without replacement using Efraimidis and Spirakis' A-ExpJ
+     *
+     * This class keeps a weighted sample of the given size out of a stream of
+     * unknown length, where each element is assigned the key u^(1 / w) (u
+     * being uniform in (0, 1) and w being the element's weight) and the
+     * elements with the largest keys are kept (A-Res).
+     *
+     * Instead of drawing a key for every element, the total weight to be
+     * discarded before the next replacement is drawn from the smallest key
+     * kept (A-ExpJ), so that only O(size * log(n / size)) random draws are
+     * needed for a stream of length n; elements falling within a jump merely
+     * have their weights subtracted from it.
+     *
+     * Keys are kept in logarithmic form (ie. log(u) / w) to avoid underflow,
+     * and the sample proper is kept in a binary min-heap thereof.
+     *
+     * Elements with non-positive weights are never sampled.
+     *
+     * The template parameters establish the type of the elements sampled,
+     * and the sponge type to draw from (a concrete type allows for every draw
+     * to be devirtualized).
+     *
+     */
+    template <typename T, typename S = Draupnir::Sponge>
+    class WeightedReservoirSampler {
+      public:
+        /**
+         * Main constructor
+         *
+         * The given sponge must outlive the sampler.
+         *
+         * @param s  Sponge to use for randomization
+         * @param size  Sample size to keep
+         */
+        WeightedReservoirSampler(S &s, std::size_t size);
+
+        /**
+         * Copy constructor - defaulted
+         *
+         * @param other  WeightedReservoirSampler to copy from
+         */
+        WeightedReservoirSampler(WeightedReservoirSampler const &other) = default;
+
+        /**
+         * Move constructor - defaulted
+         *
+         * @param other  WeightedReservoirSampler to move from
+         */
+        WeightedReservoirSampler(WeightedReservoirSampler &&other) noexcept = default;
+
+        /**
+         * Destructor - defaulted
+         *
+         */
+        ~WeightedReservoirSampler() noexcept = default;
+
+        /**
+         * Offer a single element to the sampler
+         *
+         * @param value  Element to offer
+         * @param weight  Element's weight
+         * @return true if the element was kept in the sample
+         */
+        bool offer(T const &value, double weight);
+
+        /**
+         * Offer a single element to the sampler, moving from it if kept
+         *
+         * @param value  Element to offer
+         * @param weight  Element's weight
+         * @return true if the element was kept in the sample
+         */
+        bool offer(T &&value, double weight);
+
+        /**
+         * Offer every element in the given range to the sampler
+         *
+         * Elements falling within a jump are merely iterated over, never dereferenced.
+         *
+         * @param first  Iterator pointing to the first element to offer
+         * @param last  Iterator pointing past the last element to offer
+         * @param weights  Iterator pointing to the first element's weight (one weight per element offered)
+         * @return the updated WeightedReservoirSampler
+         */
+        template <typename InputIt, typename WeightIt>
+        WeightedReservoirSampler &offer(InputIt first, InputIt last, WeightIt weights);
+
+        /**
+         * Retrieve the number of elements seen so far
+         *
+         * @return the number of elements seen
+         */
+        std::size_t seen() const noexcept;
+
+        /**
+         * Retrieve the current sample
+         *
+         * The sample holds at most size elements, in no particular order.
+         *
+         * @return a vector holding the current sample
+         */
+        std::vector<T> sample() const;
+
+      protected:
+        /**
+         * Sample entry, holding an element and its (logarithmic) key
+         *
+         */
+        struct Entry {
+          /**
+           * Logarithmic key (ie. log(u) / w)
+           *
+           */
+          double key;
+
+          /**
+           * Element proper
+           *
+           */
+          T value;
+
+          /**
+           * Heap ordering (smallest key at the top)
+           *
+           * @param other  Entry to compare against
+           * @return true if this entry's key is larger than other's
+           */
+          bool operator<(Entry const &other) const noexcept { return other.key < key; }
+        };
+
+        /**
+         * Determine the key to assign to the next element, if it is to be kept
+         *
+         * This method updates the internal state as if an element was seen.
+         *
+         * @param weight  Element's weight
+         * @param key  Output logarithmic key to assign the element
+         * @return true if the element must be kept
+         */
+        bool admit(double weight, double &key);
+
+        /**
+         * Insert the given entry into the heap, evicting the smallest key if full
+         *
+         * @param entry  Entry to insert
+         */
+        void push(Entry &&entry);
+
+        /**
+         * Draw the total weight to discard before the next replacement
+         *
+         */
+        void jump();
+
+        /**
+         * Sponge to use for randomization
+         *
+         */
+        S &_sponge;
+
+        /**
+         * Sample size to keep
+         *
+         */
+        std::size_t _size;
+
+        /**
+         * Number of elements seen so far
+         *
+         */
+        std::size_t _seen;
+
+        /**
+         * Remaining weight to discard before the next replacement
+         *
+         */
+        double _jump;
+
+        /**
+         * Sample heap
+         *
+         */
+        std::vector<Entry> _heap;
+    };
+
+  }
+
+}
+
+#include "WeightedReservoirSampler.hpp"
+
+#endif /* DRAUPNIR_WEIGHTED_RESERVOIR_SAMPLER_H__ */
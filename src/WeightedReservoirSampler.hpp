@@ -0,0 +1,198 @@
+#ifndef DRAUPNIR_WEIGHTED_RESERVOIR_SAMPLER_HPP__
+#define DRAUPNIR_WEIGHTED_RESERVOIR_SAMPLER_HPP__
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include "WeightedReservoirSampler.h"
+#include "Random.h"
+
+namespace Draupnir {
+
+  namespace Random {
+
+    /**
+     * WeightedReservoirSampler main constructor
+     *
+     * The given sponge must outlive the sampler.
+     *
+     * @param s  Sponge to use for randomization
+     * @param size  Sample size to keep
+     */
+    template <typename T, typename S>
+    WeightedReservoirSampler<T, S>::WeightedReservoirSampler(S &s, std::size_t size)
+      :
+    _sponge {s},
+    _size {size},
+    _seen {0},
+    _jump {0.0},
+    _heap {}
+    {
+      _heap.reserve(size);
+    }
+
+    /**
+     * Offer a single element to the sampler
+     *
+     * @param value  Element to offer
+     * @param weight  Element's weight
+     * @return true if the element was kept in the sample
+     */
+    template <typename T, typename S>
+    bool WeightedReservoirSampler<T, S>::offer(T const &value, double weight) {
+      double key;
+      if (!admit(weight, key)) {
+        return false;
+      }
+      push(Entry{key, value});
+      return true;
+    }
+
+    /**
+     * Offer a single element to the sampler, moving from it if kept
+     *
+     * @param value  Element to offer
+     * @param weight  Element's weight
+     * @return true if the element was kept in the sample
+     */
+    template <typename T, typename S>
+    bool WeightedReservoirSampler<T, S>::offer(T &&value, double weight) {
+      double key;
+      if (!admit(weight, key)) {
+        return false;
+      }
+      push(Entry{key, std::move(value)});
+      return true;
+    }
+
+    /**
+     * Offer every element in the given range to the sampler
+     *
+     * Elements falling within a jump are merely iterated over, never dereferenced.
+     *
+     * @param first  Iterator pointing to the first element to offer
+     * @param last  Iterator pointing past the last element to offer
+     * @param weights  Iterator pointing to the first element's weight (one weight per element offered)
+     * @return the updated WeightedReservoirSampler
+     */
+    template <typename T, typename S>
+    template <typename InputIt, typename WeightIt>
+    WeightedReservoirSampler<T, S> &WeightedReservoirSampler<T, S>::offer(InputIt first, InputIt last, WeightIt weights) {
+      for (; first != last; ++first, ++weights) {
+        double key;
+        if (admit(static_cast<double>(*weights), key)) {
+          push(Entry{key, *first});
+        }
+      }
+      return *this;
+    }
+
+    /**
+     * Retrieve the number of elements seen so far
+     *
+     * @return the number of elements seen
+     */
+    template <typename T, typename S>
+    std::size_t WeightedReservoirSampler<T, S>::seen() const noexcept {
+      return _seen;
+    }
+
+    /**
+     * Retrieve the current sample
+     *
+     * The sample holds at most size elements, in no particular order.
+     *
+     * @return a vector holding the current sample
+     */
+    template <typename T, typename S>
+    std::vector<T> WeightedReservoirSampler<T, S>::sample() const {
+      std::vector<T> result;
+      result.reserve(_heap.size());
+      for (auto const &entry : _heap) {
+        result.push_back(entry.value);
+      }
+      return result;
+    }
+
+    /**
+     * Determine the key to assign to the next element, if it is to be kept
+     *
+     * This method updates the internal state as if an element was seen.
+     *
+     * Once the reservoir is full, the element's weight is subtracted from the
+     * current jump, and only if the jump is exhausted is a new key drawn; since
+     * the element is known to beat the smallest key t kept, its key is drawn
+     * uniformly between t^w and 1 (in logarithmic form).
+     *
+     * @param weight  Element's weight
+     * @param key  Output logarithmic key to assign the element
+     * @return true if the element must be kept
+     */
+    template <typename T, typename S>
+    bool WeightedReservoirSampler<T, S>::admit(double weight, double &key) {
+      _seen++;
+
+      if (!(0.0 < weight)) {
+        return false;
+      }
+
+      // still filling up the reservoir
+      if (_heap.size() < _size) {
+        key = std::log(openReal(_sponge)) / weight;
+        return true;
+      }
+
+      // within a jump (or not sampling at all): discard
+      _jump -= weight;
+      if (0 == _size || 0.0 < _jump) {
+        return false;
+      }
+
+      // landed: draw a key beating the smallest one kept
+      double t = std::exp(_heap.front().key * weight);
+      key = std::log(t + (1.0 - t) * openReal(_sponge)) / weight;
+      return true;
+    }
+
+    /**
+     * Insert the given entry into the heap, evicting the smallest key if full
+     *
+     * A new jump is drawn whenever the smallest key kept changes with the
+     * reservoir full.
+     *
+     * @param entry  Entry to insert
+     */
+    template <typename T, typename S>
+    void WeightedReservoirSampler<T, S>::push(Entry &&entry) {
+      if (_heap.size() < _size) {
+        _heap.push_back(std::move(entry));
+        std::push_heap(_heap.begin(), _heap.end());
+      } else {
+        std::pop_heap(_heap.begin(), _heap.end());
+        _heap.back() = std::move(entry);
+        std::push_heap(_heap.begin(), _heap.end());
+      }
+
+      if (_heap.size() == _size) {
+        jump();
+      }
+    }
+
+    /**
+     * Draw the total weight to discard before the next replacement
+     *
+     * If t is the smallest key kept, the total weight to discard is
+     * log(u) / log(t), u being uniform in (0, 1).
+     *
+     */
+    template <typename T, typename S>
+    void WeightedReservoirSampler<T, S>::jump() {
+      _jump = std::log(openReal(_sponge)) / _heap.front().key;
+    }
+
+  }
+
+}
+
+#endif /* DRAUPNIR_WEIGHTED_RESERVOIR_SAMPLER_HPP__ */
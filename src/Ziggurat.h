@@ -0,0 +1,62 @@
+#ifndef DRAUPNIR_ZIGGURAT_H__
+#define DRAUPNIR_ZIGGURAT_H__
+
+#include <array>
+
+namespace Draupnir {
+
+  namespace Random {
+
+    /**
+     * Number of layers in the ziggurat tables
+     *
+     */
+    constexpr std::size_t zigguratLayers = 256;
+
+    /**
+     * Rightmost layer boundary (ie. tail start) for the standard normal distribution
+     *
+     */
+    constexpr double zigguratNormalR = 3.6541528853610088;
+
+    /**
+     * Rightmost layer boundary (ie. tail start) for the standard exponential distribution
+     *
+     */
+    constexpr double zigguratExponentialR = 7.69711747013104972;
+
+    /**
+     * Ziggurat layer boundaries for the standard normal distribution
+     *
+     * Entry 0 holds the area of the tail divided by the density at R (ie.
+     * a virtual layer width), entry 1 holds R itself, and entry 256 holds 0.
+     *
+     */
+    extern const std::array<double, zigguratLayers + 1> zigguratNormalX;
+
+    /**
+     * Standard normal (unnormalized) density at each of the ziggurat layer boundaries
+     *
+     */
+    extern const std::array<double, zigguratLayers + 1> zigguratNormalF;
+
+    /**
+     * Ziggurat layer boundaries for the standard exponential distribution
+     *
+     * Entry 0 holds the area of the tail divided by the density at R (ie.
+     * a virtual layer width), entry 1 holds R itself, and entry 256 holds 0.
+     *
+     */
+    extern const std::array<double, zigguratLayers + 1> zigguratExponentialX;
+
+    /**
+     * Standard exponential density at each of the ziggurat layer boundaries
+     *
+     */
+    extern const std::array<double, zigguratLayers + 1> zigguratExponentialF;
+
+  }
+
+}
+
+#endif /* DRAUPNIR_ZIGGURAT_H__ */
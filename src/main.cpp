@@ -1,7 +1,26 @@
 #include "Draupnir.h"
+#include "Environment.h"
+#include "ExternalShuffle.h"
+#include "Graph.h"
+#include "LineReader.h"
+#include "ParallelShuffle.h"
+#include "ReservoirSampler.h"
+#include "Script.h"
+#include "SpongeStack.h"
 
 
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
 #include <iostream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
 using namespace std;
 
@@ -19,6 +38,112 @@ static void showLogo() {
           "\n";
 }
 
+/**
+ * Write a uniform sample of the lines in the given file to cout
+ *
+ * Lines falling within the sampler's geometric jumps are skipped by merely
+ * scanning for their terminators; only the lines landed upon are copied.
+ *
+ * @param s  Sponge to use for randomization
+ * @param count  Number of lines to sample
+ * @param path  Path to the file to sample from ("-" for cin)
+ */
+template <typename S>
+static void sampleLines(S &s, std::size_t count, string const &path) {
+  Draupnir::LineReader input(path);
+  Draupnir::Random::ReservoirSampler<string, S> sampler(s, count);
+
+  char const *line;
+  std::size_t length;
+  while (true) {
+    std::size_t skip = sampler.skip();
+    std::size_t skipped = input.skip(skip);
+    sampler.discard(skipped);
+    if (skipped < skip || !input.next(line, length)) {
+      break;
+    }
+    sampler.offer(string(line, length));
+  }
+
+  for (auto const &x : sampler.sample()) {
+    cout << x << '\n';
+  }
+  cout.flush();
+}
+
+/**
+ * Write a random permutation of the numbers between 0 and count - 1 to the given file
+ *
+ * The file is created (or truncated), sized to hold count native-endian 64
+ * bit words, and mmap'ed, so that the permutation is generated in place.
+ *
+ * @param s  Sponge to use for randomization
+ * @param count  Permutation size
+ * @param path  Path to the file to write
+ * @param threads  Number of threads to use (0 to use the hardware concurrency)
+ * @throws std::system_error in case the file cannot be created, sized, or mapped
+ */
+template <typename S>
+static void permuteToFile(S &s, std::size_t count, string const &path, std::size_t threads) {
+  int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    throw std::system_error(errno, std::system_category(), "Cannot open '" + path + "'");
+  }
+
+  std::size_t size = count * sizeof(std::uint64_t);
+  if (0 != ::ftruncate(fd, static_cast<off_t>(size))) {
+    int error = errno;
+    ::close(fd);
+    throw std::system_error(error, std::system_category(), "Cannot size '" + path + "'");
+  }
+  if (0 == size) {
+    ::close(fd);
+    return;
+  }
+
+  void *map = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  int error = errno;
+  ::close(fd);
+  if (MAP_FAILED == map) {
+    throw std::system_error(error, std::system_category(), "Cannot map '" + path + "'");
+  }
+
+  std::uint64_t *data = static_cast<std::uint64_t *>(map);
+  Draupnir::Random::parallelPermutation(s, data, data + count, threads);
+  ::munmap(map, size);
+}
+
+/**
+ * Write the edges of a random graph to the given file
+ *
+ * Each edge is written as a pair of native-endian 64 bit words holding its
+ * endpoints; each pair is written with a single (thus atomic) fwrite call,
+ * so that the generator may report edges from several threads at once, in
+ * which case their order in the file is unspecified.
+ *
+ * @param path  Path to the file to write
+ * @param generate  Function to call with the edge writing function
+ * @throws std::system_error in case the file cannot be created or written
+ */
+template <typename F>
+static void graphToFile(string const &path, F const &generate) {
+  std::FILE *file = std::fopen(path.c_str(), "wb");
+  if (nullptr == file) {
+    throw std::system_error(errno, std::system_category(), "Cannot open '" + path + "'");
+  }
+
+  generate([file](std::size_t u, std::size_t v) {
+    std::uint64_t endpoints[2] = {u, v};
+    std::fwrite(endpoints, sizeof(endpoints), 1, file);
+  });
+
+  bool failed = 0 != std::ferror(file);
+  int error = errno;
+  if (0 != std::fclose(file) || failed) {
+    throw std::system_error(failed ? error : errno, std::system_category(), "Cannot write '" + path + "'");
+  }
+}
+
 
 int main(int argc, char *argv[]) {
   showLogo();
@@ -29,11 +154,109 @@ int main(int argc, char *argv[]) {
   }
   cerr << endl;
 
-  Draupnir::CrcSponge64 d = Draupnir::CrcSponge64Builder();
+  // sponge selection: draupnir [--seed <text> | --load <dump>] <mode> ...
+  // (the option is shifted away afterwards, so that modes see their usual arguments)
+  Draupnir::SpongeStack sponges;
+  try {
+    if (3 <= argc && string("--load") == argv[1]) {
+      sponges.load(argv[2]);
+      argc -= 2;
+      argv += 2;
+    } else {
+      Draupnir::CrcSponge64 d = Draupnir::CrcSponge64Builder();
+      if (3 <= argc && string("--seed") == argv[1]) {
+        d.soak(argv[2]);
+        argc -= 2;
+        argv += 2;
+      }
+      sponges.push(d);
+    }
+  } catch (std::exception const &e) {
+    cerr << e.what() << endl;
+    return 1;
+  }
 
-  while (true) {
-    cout << d.squeeze();
+  // line sampling mode: draupnir lines <count> [file]
+  if (3 <= argc && string("lines") == argv[1]) {
+    try {
+      sponges.top([&](auto &d) { sampleLines(d, std::stoull(argv[2]), 3 < argc ? argv[3] : "-"); });
+    } catch (std::exception const &e) {
+      cerr << e.what() << endl;
+      return 1;
+    }
+    return 0;
+  }
+
+  // permutation mode: draupnir permute <count> <file> [threads]
+  if (4 <= argc && string("permute") == argv[1]) {
+    try {
+      sponges.top([&](auto &d) { permuteToFile(d, std::stoull(argv[2]), argv[3], 4 < argc ? std::stoull(argv[4]) : 0); });
+    } catch (std::exception const &e) {
+      cerr << e.what() << endl;
+      return 1;
+    }
+    return 0;
+  }
+
+  // external shuffling mode: draupnir shuffle <file> <output> [threads] [buckets]
+  if (4 <= argc && string("shuffle") == argv[1]) {
+    try {
+      char const *directory = std::getenv("TMPDIR");
+      sponges.top([&](auto &d) { Draupnir::Random::shuffleLines(d, argv[2], argv[3], nullptr != directory ? directory : "/tmp", 5 < argc ? std::stoull(argv[5]) : 0, 4 < argc ? std::stoull(argv[4]) : 0); });
+    } catch (std::exception const &e) {
+      cerr << e.what() << endl;
+      return 1;
+    }
+    return 0;
   }
+
+  // script mode: draupnir run <script> [threads]
+  if (3 <= argc && string("run") == argv[1]) {
+    try {
+      Draupnir::Script script = Draupnir::Script::compile(argv[2]);
+      Draupnir::Environment env(cout, cerr, 3 < argc ? std::stoull(argv[3]) : 0);
+      sponges.top([&env](auto &d) { env.load(d.dump()); });
+      script.run(env);
+      cout.flush();
+    } catch (std::exception const &e) {
+      cerr << e.what() << endl;
+      return 1;
+    }
+    return 0;
+  }
+
+  // graph modes: draupnir graph gnp <n> <p> <file> [threads]
+  //              draupnir graph gnm <n> <m> <file>
+  //              draupnir graph bipartite <n1> <n2> <p> <file> [threads]
+  if (6 <= argc && string("graph") == argv[1]) {
+    try {
+      string kind = argv[2];
+      if ("gnp" == kind) {
+        std::size_t n = std::stoull(argv[3]), threads = 6 < argc ? std::stoull(argv[6]) : 0;
+        double p = std::stod(argv[4]);
+        sponges.top([&](auto &d) { graphToFile(argv[5], [&](auto const &edge) { Draupnir::Random::gnpGraph(d, n, p, edge, threads); }); });
+      } else if ("gnm" == kind) {
+        std::size_t n = std::stoull(argv[3]), m = std::stoull(argv[4]);
+        sponges.top([&](auto &d) { graphToFile(argv[5], [&](auto const &edge) { Draupnir::Random::gnmGraph(d, n, m, edge); }); });
+      } else if ("bipartite" == kind && 7 <= argc) {
+        std::size_t n1 = std::stoull(argv[3]), n2 = std::stoull(argv[4]), threads = 7 < argc ? std::stoull(argv[7]) : 0;
+        double p = std::stod(argv[5]);
+        sponges.top([&](auto &d) { graphToFile(argv[6], [&](auto const &edge) { Draupnir::Random::bipartiteGraph(d, n1, n2, p, edge, threads); }); });
+      } else {
+        throw std::invalid_argument("Unknown graph kind '" + kind + "'");
+      }
+    } catch (std::exception const &e) {
+      cerr << e.what() << endl;
+      return 1;
+    }
+    return 0;
+  }
+
+  sponges.top([](auto &d) {
+    while (true) {
+      cout << d.squeeze();
+    }
+  });
   return 0;
 }
 
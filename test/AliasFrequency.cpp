@@ -0,0 +1,62 @@
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "Draupnir.h"
+#include "Random.h"
+
+
+namespace {
+
+/**
+ * Check the alias method's output frequencies against the distribution it was built from
+ *
+ * The parts used make the alias table building absorb a column that has
+ * already absorbed another one (and thus carries a multiplicity greater than
+ * one), exercising the multiplicity bookkeeping.
+ *
+ * @param parts  Distribution specified as parts-to-parts
+ * @param draws  Number of values to draw
+ * @param tolerance  Maximum absolute deviation allowed for each frequency
+ * @return true if every frequency lies within tolerance of its expected value
+ */
+bool checkFrequencies(std::vector<std::size_t> const &parts, std::size_t draws, double tolerance) {
+  Draupnir::CrcSponge64 sponge = Draupnir::CrcSponge64Builder();
+
+  std::vector<std::size_t> sample = Draupnir::Random::nonUniformSampleWithReplacement(sponge, parts, draws);
+
+  std::size_t total = 0;
+  for (std::size_t part : parts) {
+    total += part;
+  }
+  std::vector<std::size_t> counts(parts.size(), 0);
+  for (std::size_t x : sample) {
+    counts[x]++;
+  }
+
+  bool ok = true;
+  for (std::size_t i = 0; i < parts.size(); i++) {
+    double expected = static_cast<double>(parts[i]) / static_cast<double>(total);
+    double observed = static_cast<double>(counts[i]) / static_cast<double>(draws);
+    bool good = std::fabs(observed - expected) <= tolerance;
+    std::cout << "  " << i << ": expected " << expected << ", observed " << observed << (good ? "" : "  <-- FAIL") << std::endl;
+    ok = ok && good;
+  }
+  return ok;
+}
+
+}
+
+
+int main() {
+  bool ok = true;
+
+  std::cout << "parts 20 12 6 3 15" << std::endl;
+  ok = checkFrequencies({20, 12, 6, 3, 15}, 400000, 0.01) && ok;
+
+  std::cout << "parts 100 1 1 1 1 1 1 1" << std::endl;
+  ok = checkFrequencies({100, 1, 1, 1, 1, 1, 1, 1}, 400000, 0.01) && ok;
+
+  return ok ? 0 : 1;
+}